@@ -0,0 +1,84 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include <autoware_msgs/Waypoint.h>
+
+#include "frenet_planner.h"
+#include "worker_pool.h"
+#include "vectormap_struct.h"
+#include "calculate_center_line.h"
+
+// reports FrenetPlanner::planBatch throughput on a synthetic curved lane
+// usage: benchmark_batch_planning [number of scenarios] [number of threads]
+namespace
+{
+const size_t DEFAULT_NUM_SCENARIOS = 200;
+const double WAYPOINT_INTERVAL = 0.5;
+const size_t NUM_WAYPOINTS = 120;
+const double MAX_START_OFFSET = 1.0;
+
+std::vector<autoware_msgs::Waypoint> generateCurvedLane()
+{
+  std::vector<autoware_msgs::Waypoint> waypoints;
+  for(size_t i = 0; i < NUM_WAYPOINTS; i++)
+  {
+    double x = i*WAYPOINT_INTERVAL;
+    autoware_msgs::Waypoint waypoint;
+    waypoint.pose.pose.position.x = x;
+    waypoint.pose.pose.position.y = 0.002*x*x;
+    waypoints.push_back(waypoint);
+  }
+  return waypoints;
+}
+
+void report(const char* label, const BatchPlanningResult& result)
+{
+  size_t num_valid = 0;
+  for(const auto& output: result.outputs)
+  {
+    num_valid += output.is_valid ? 1 : 0;
+  }
+  std::cout << label
+            << ": " << result.outputs.size() << " scenarios"
+            << ", " << num_valid << " valid"
+            << ", " << result.elapsed_second << " sec"
+            << ", " << result.scenarios_per_second << " scenarios/sec" << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+  size_t num_scenarios = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DEFAULT_NUM_SCENARIOS;
+  size_t num_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+  std::vector<autoware_msgs::Waypoint> waypoints = generateCurvedLane();
+  CalculateCenterLine calculate_center_line;
+  std::vector<Point> lane_points = calculate_center_line.calculateCenterLineFromGlobalWaypoints(waypoints);
+
+  // same values as the defaults of frenet_planner.launch
+  const double kmh2ms = 0.2778;
+  FrenetPlanner frenet_planner(
+    2.1*kmh2ms, 1.0*kmh2ms, 7.0, 1.3, 5.0, 8.0, 1.0, 1.0, 0.0, 0.0, 0.0,
+    2.0/kmh2ms, 2.36/kmh2ms, 5.0*kmh2ms,
+    std::make_shared<WorkerPool>(num_threads));
+
+  std::vector<PlanningScenario> scenarios(num_scenarios);
+  for(size_t i = 0; i < scenarios.size(); i++)
+  {
+    PlanningScenario& scenario = scenarios[i];
+    scenario.current_pose.pose.position.x = 1.0;
+    scenario.current_pose.pose.position.y =
+      MAX_START_OFFSET*(2.0*static_cast<double>(i)/static_cast<double>(num_scenarios) - 1.0);
+    scenario.current_pose.pose.orientation.w = 1.0;
+    scenario.lane_points = lane_points;
+    scenario.reference_waypoints = waypoints;
+    scenario.has_objects = false;
+  }
+
+  report("with debug trajectories", frenet_planner.planBatch(scenarios, true));
+  report("without debug trajectories", frenet_planner.planBatch(scenarios, false));
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+#include "clearance_map_generator.h"
+
+// incremental clearance map update against the full distance transform per costmap frame
+// usage: benchmark_clearance_map [number of changed cells per frame] [number of threads]
+namespace
+{
+const int ROWS = 400;
+const int COLS = 400;
+const double RESOLUTION = 0.1;
+const int NUM_OBSTACLES = 4000;
+const int NUM_FRAMES = 50;
+const int DEFAULT_NUM_CHANGED_CELLS = 200;
+
+double calculateElapsedMilliSecond(const std::chrono::steady_clock::time_point& begin)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+}
+
+int main(int argc, char** argv)
+{
+  const int num_changed_cells = argc > 1 ? std::atoi(argv[1]) : DEFAULT_NUM_CHANGED_CELLS;
+  const size_t num_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+  std::mt19937 random_engine(0);
+  std::uniform_int_distribution<int> random_row(0, ROWS - 1);
+  std::uniform_int_distribution<int> random_col(0, COLS - 1);
+  grid_map::Matrix costmap = grid_map::Matrix::Zero(ROWS, COLS);
+  for(int i = 0; i < NUM_OBSTACLES; i++)
+  {
+    costmap(random_row(random_engine), random_col(random_engine)) = 1;
+  }
+
+  ClearanceMapGenerator full_generator(num_threads);
+  ClearanceMapGenerator incremental_generator(num_threads);
+  const grid_map::Position map_position = grid_map::Position::Zero();
+  grid_map::Matrix clearance = costmap;
+  incremental_generator.updateClearanceMap(clearance, map_position, RESOLUTION);
+
+  double full_milli_second = 0;
+  double incremental_milli_second = 0;
+  for(int frame = 0; frame < NUM_FRAMES; frame++)
+  {
+    for(int i = 0; i < num_changed_cells; i++)
+    {
+      float& cost = costmap(random_row(random_engine), random_col(random_engine));
+      cost = cost > 0 ? 0 : 1;
+    }
+
+    clearance = costmap;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    full_generator.generateClearanceMap(clearance);
+    full_milli_second += calculateElapsedMilliSecond(begin);
+
+    clearance = costmap;
+    begin = std::chrono::steady_clock::now();
+    incremental_generator.updateClearanceMap(clearance, map_position, RESOLUTION);
+    incremental_milli_second += calculateElapsedMilliSecond(begin);
+  }
+
+  std::cout << ROWS << "x" << COLS << " cells, " << num_changed_cells << " changed cells per frame" << std::endl;
+  std::cout << "full distance transform " << full_milli_second/NUM_FRAMES << " milli sec per frame" << std::endl;
+  std::cout << "incremental update " << incremental_milli_second/NUM_FRAMES << " milli sec per frame" << std::endl;
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+#include "clearance_sampler.h"
+#include "tiled_clearance_grid.h"
+
+// clearance lookups of the bubble search from the float layer against the tiled centimetre grid
+// usage: benchmark_tiled_clearance_grid [rows] [cols]
+namespace
+{
+const int DEFAULT_ROWS = 1000;
+const int DEFAULT_COLS = 1000;
+const double RESOLUTION = 0.1;
+const double MAX_CLEARANCE = 10.0;
+const int NUM_LOOKUPS = 2000000;
+// lookups are on rims of bubbles whose centers walk through the map, as in the bubble A*
+const int LOOKUPS_PER_BUBBLE = 36;
+const double MIN_BUBBLE_STEP = 0.5;
+const double MAX_BUBBLE_STEP = 10.0;
+const double BUBBLE_RADIUS = 3.0;
+const int NUM_REPEATS = 5;
+
+double calculateNanoSecondPerLookup(const std::chrono::steady_clock::time_point& begin)
+{
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count()/NUM_LOOKUPS;
+}
+}
+
+int main(int argc, char** argv)
+{
+  const int rows = argc > 1 ? std::atoi(argv[1]) : DEFAULT_ROWS;
+  const int cols = argc > 2 ? std::atoi(argv[2]) : DEFAULT_COLS;
+
+  std::mt19937 random_engine(0);
+  std::uniform_real_distribution<float> random_clearance(0, MAX_CLEARANCE/RESOLUTION);
+  grid_map::Matrix clearance_data(rows, cols);
+  for(int i = 0; i < clearance_data.size(); i++)
+  {
+    clearance_data.data()[i] = random_clearance(random_engine);
+  }
+  const grid_map::Position map_position = grid_map::Position::Zero();
+  const ClearanceSampler clearance_sampler(clearance_data, map_position, RESOLUTION, RESOLUTION,
+                                           ClearanceSampler::Interpolation::Nearest);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  TiledClearanceGrid tiled_clearance_grid;
+  tiled_clearance_grid.build(clearance_data, map_position, RESOLUTION, RESOLUTION);
+  const double build_milli_second =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+  std::uniform_real_distribution<double> random_angle(0, 2*M_PI);
+  std::uniform_real_distribution<double> random_step(MIN_BUBBLE_STEP, MAX_BUBBLE_STEP);
+  const Eigen::Vector2d half_length = 0.5*RESOLUTION*Eigen::Vector2d(rows, cols);
+  Eigen::Matrix2Xd positions(2, NUM_LOOKUPS);
+  Eigen::Vector2d bubble_center = Eigen::Vector2d::Zero();
+  for(int i = 0; i < NUM_LOOKUPS; i++)
+  {
+    if(i%LOOKUPS_PER_BUBBLE == 0)
+    {
+      const double angle = random_angle(random_engine);
+      bubble_center += random_step(random_engine)*Eigen::Vector2d(std::cos(angle), std::sin(angle));
+      bubble_center = bubble_center.cwiseMax(-half_length).cwiseMin(half_length);
+    }
+    const double angle = random_angle(random_engine);
+    positions.col(i) = bubble_center + BUBBLE_RADIUS*Eigen::Vector2d(std::cos(angle), std::sin(angle));
+  }
+
+  Eigen::VectorXd float_clearances, tiled_clearances;
+  double float_nano_second = std::numeric_limits<double>::max();
+  double tiled_nano_second = std::numeric_limits<double>::max();
+  for(int i = 0; i < NUM_REPEATS; i++)
+  {
+    begin = std::chrono::steady_clock::now();
+    clearance_sampler.sample(positions, float_clearances, -1);
+    float_nano_second = std::min(float_nano_second, calculateNanoSecondPerLookup(begin));
+    begin = std::chrono::steady_clock::now();
+    tiled_clearance_grid.sample(positions, tiled_clearances, -1);
+    tiled_nano_second = std::min(tiled_nano_second, calculateNanoSecondPerLookup(begin));
+  }
+
+  std::cout << rows << "x" << cols << " cells" << std::endl;
+  std::cout << "float layer " << clearance_data.size()*sizeof(float)/1024 << " KiB, "
+            << float_nano_second << " nano sec per lookup" << std::endl;
+  std::cout << "tiled grid " << tiled_clearance_grid.getMemoryBytes()/1024 << " KiB, "
+            << tiled_nano_second << " nano sec per lookup, build " << build_milli_second << " milli sec" << std::endl;
+  std::cout << "max difference " << (float_clearances - tiled_clearances).cwiseAbs().maxCoeff() << " m" << std::endl;
+  return 0;
+}
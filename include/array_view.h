@@ -0,0 +1,92 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ARRAY_VIEW_H
+#define ARRAY_VIEW_H
+
+#include <vector>
+#include <cstddef>
+
+// read-only view of contiguous elements owned by someone else, e.g. the tail of a path;
+// valid as long as the viewed storage is neither destroyed nor reallocated
+template <typename T>
+class ArrayView
+{
+public:
+  ArrayView()
+  : data_(nullptr), size_(0)
+  {
+  }
+
+  ArrayView(const T* data, const size_t size)
+  : data_(data), size_(size)
+  {
+  }
+
+  // implicit so that a whole vector can be passed where a view is expected
+  ArrayView(const std::vector<T>& elements)
+  : data_(elements.data()), size_(elements.size())
+  {
+  }
+
+  // elements from offset to the end; empty if offset is out of range
+  ArrayView(const std::vector<T>& elements, const size_t offset)
+  : data_(elements.data() + (offset < elements.size() ? offset : elements.size())),
+    size_(offset < elements.size() ? elements.size() - offset : 0)
+  {
+  }
+
+  const T* begin() const
+  {
+    return data_;
+  }
+
+  const T* end() const
+  {
+    return data_ + size_;
+  }
+
+  const T& operator[](const size_t index) const
+  {
+    return data_[index];
+  }
+
+  const T& front() const
+  {
+    return data_[0];
+  }
+
+  const T& back() const
+  {
+    return data_[size_ - 1];
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+private:
+  const T* data_;
+  size_t size_;
+};
+
+#endif
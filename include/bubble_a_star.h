@@ -0,0 +1,106 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BUBBLE_A_STAR_H
+#define BUBBLE_A_STAR_H
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+//headers in Eigen
+#include <Eigen/Core>
+
+struct BubbleNode
+{
+  Eigen::Vector2d p;
+  double r;
+  double g;
+  double h;
+  double f;
+  // index in the node pool; -1 for the start node
+  int parent_index;
+};
+
+struct BubbleAStarStatistics
+{
+  size_t number_of_expansions;
+  size_t number_of_generated_nodes;
+  size_t number_of_skipped_nodes;
+  size_t number_of_pruned_children;
+  double elapsed_second;
+};
+
+// A* over free-space bubbles: each node is a disc of its clearance radius,
+// children are placed on the rim of the parent and a node inside a closed bubble is skipped
+class BubbleAStar
+{
+public:
+  // returns false if position is out of the map; clearance in metres
+  typedef std::function<bool(const Eigen::Vector2d& position, double& clearance)> ClearanceFunction;
+  // estimated path length from position to the goal; euclidean distance if empty
+  typedef std::function<double(const Eigen::Vector2d& position)> HeuristicFunction;
+  
+  // use_adaptive_branching: expand fewer directions from large bubbles and more from small ones;
+  // otherwise always 36
+  BubbleAStar(const double min_r, const double max_r, const bool use_adaptive_branching);
+  ~BubbleAStar();
+  
+  // returns true if a bubble overlapping the goal bubble is found; stops as soon as it is popped
+  bool search(const Eigen::Vector2d& start_p,
+              const double start_r,
+              const Eigen::Vector2d& goal_p,
+              const double goal_r,
+              const ClearanceFunction& clearance_function,
+              const HeuristicFunction& heuristic_function = HeuristicFunction());
+  
+  // node pool of the last search
+  const std::vector<BubbleNode>& getNodes() const;
+  
+  // pool indices in the order nodes were closed
+  const std::vector<int>& getClosedNodeIndices() const;
+  
+  // pool index of the bubble overlapping the goal; the last closed node if not found
+  int getLastNodeIndex() const;
+  
+  const BubbleAStarStatistics& getStatistics() const;
+  
+  // whether two bubbles overlap enough to be connected; used as the goal condition
+  static bool isOverlap(const BubbleNode& node1, const BubbleNode& node2);
+  
+private:
+  typedef std::pair<double, int> OpenElement;
+  
+  const double min_r_;
+  const double max_r_;
+  const bool use_adaptive_branching_;
+  
+  std::vector<BubbleNode> nodes_;
+  std::vector<int> closed_node_indices_;
+  int last_node_index_;
+  BubbleAStarStatistics statistics_;
+  
+  // closed nodes hashed by cells of max_r, so a node only has to be checked against 3x3 cells
+  std::unordered_map<int64_t, std::vector<int>> closed_node_hash_;
+  
+  int selectDirectionStride(const double r) const;
+  int64_t calculateHashKey(const int cell_x, const int cell_y) const;
+  void addClosedNode(const int node_index);
+  bool isInsideClosedNode(const Eigen::Vector2d& position) const;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CLEARANCE_MAP_GENERATOR_H
+#define CLEARANCE_MAP_GENERATOR_H
+
+#include <memory>
+#include <vector>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+class DynamicClearanceMap;
+
+// runs the distance transform directly on a grid_map layer's storage
+class ClearanceMapGenerator
+{
+public:
+  // 0 means std::thread::hardware_concurrency()
+  explicit ClearanceMapGenerator(const size_t num_threads);
+  ~ClearanceMapGenerator();
+  
+  // in place: cells whose cost > 0.01 become 0, the others the distance in cells to the nearest of them
+  // returns false if no cell has cost; every cell is then set to 1
+  bool generateClearanceMap(grid_map::Matrix& costmap_data) const;
+  
+  // corridor variant: only cells within corridor_half_width_cells of the polyline through corridor_indices
+  // get their clearance; the polyline is in cell indices
+  // the transform covers margin_cells around the corridor so that obstacles just outside of it are still seen;
+  // cells farther than margin_cells from the corridor do not affect clearance capped at margin_cells
+  // every cell outside the corridor is set to saturated_value
+  bool generateClearanceMap(grid_map::Matrix& costmap_data,
+                            const std::vector<grid_map::Index>& corridor_indices,
+                            const double corridor_half_width_cells,
+                            const int margin_cells,
+                            const float saturated_value) const;
+  
+  // same output as generateClearanceMap, but keeps the previous frame and only propagates cells that changed
+  // map_position is the center of the map; it has to be given in the same frame every call
+  // falls back to computing from scratch when the size or resolution changes or the map moves by a non-integer cell
+  bool updateClearanceMap(grid_map::Matrix& costmap_data,
+                          const grid_map::Position& map_position,
+                          const double resolution);
+  
+  // number of cells whose occupancy changed in the last updateClearanceMap; all cells if computed from scratch
+  size_t getNumberOfChangedCells() const;
+  
+private:
+  const size_t num_threads_;
+  std::unique_ptr<DynamicClearanceMap> dynamic_clearance_map_ptr_;
+  grid_map::Position previous_map_position_;
+  double previous_resolution_;
+  size_t number_of_changed_cells_;
+  
+  bool transformDistance(grid_map::Matrix& data) const;
+};
+
+#endif
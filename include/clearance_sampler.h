@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CLEARANCE_SAMPLER_H
+#define CLEARANCE_SAMPLER_H
+
+#include <cmath>
+#include <algorithm>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+//headers in Eigen
+#include <Eigen/Core>
+
+// reads clearance in metres from the raw buffer of a clearance layer without exceptions
+// same index convention as grid_map: index (0, 0) is the corner of max x and max y,
+// index = floor((corner - position)/resolution)
+class ClearanceSampler
+{
+public:
+  enum class Interpolation
+  {
+    Nearest,
+    Bilinear
+  };
+  
+  // data has to start at index (0, 0) and outlive the sampler
+  // meters_per_unit converts a cell value into metres; the resolution for a distance transform in cells
+  ClearanceSampler(const grid_map::Matrix& data,
+                   const grid_map::Position& map_position,
+                   const double resolution,
+                   const double meters_per_unit,
+                   const Interpolation interpolation):
+  data_(data),
+  top_left_corner_(map_position + 0.5*resolution*Eigen::Vector2d(data.rows(), data.cols())),
+  inverse_resolution_(1.0/resolution),
+  meters_per_unit_(meters_per_unit),
+  interpolation_(interpolation)
+  {
+  }
+  
+  // returns false if position is out of the map; clearance is untouched then
+  bool sample(const Eigen::Vector2d& position, double& clearance) const
+  {
+    const double u = (top_left_corner_(0) - position(0))*inverse_resolution_;
+    const double v = (top_left_corner_(1) - position(1))*inverse_resolution_;
+    if(!(u >= 0 && u < data_.rows() && v >= 0 && v < data_.cols()))
+    {
+      return false;
+    }
+    if(interpolation_ == Interpolation::Nearest)
+    {
+      clearance = data_(static_cast<int>(u), static_cast<int>(v))*meters_per_unit_;
+      return true;
+    }
+    // between the centers of the surrounding cells; clamped at the border of the map
+    const double center_u = u - 0.5;
+    const double center_v = v - 0.5;
+    const int row = std::floor(center_u);
+    const int col = std::floor(center_v);
+    const double weight_u = center_u - row;
+    const double weight_v = center_v - col;
+    const int row0 = std::max(row, 0);
+    const int col0 = std::max(col, 0);
+    const int row1 = std::min(row + 1, static_cast<int>(data_.rows()) - 1);
+    const int col1 = std::min(col + 1, static_cast<int>(data_.cols()) - 1);
+    const double value = (1 - weight_u)*((1 - weight_v)*data_(row0, col0) + weight_v*data_(row0, col1)) +
+                         weight_u*((1 - weight_v)*data_(row1, col0) + weight_v*data_(row1, col1));
+    clearance = value*meters_per_unit_;
+    return true;
+  }
+  
+  // one column per position; out of map positions get invalid_clearance
+  // returns the number of positions in the map
+  size_t sample(const Eigen::Matrix2Xd& positions,
+                Eigen::VectorXd& clearances,
+                const double invalid_clearance) const
+  {
+    clearances.resize(positions.cols());
+    size_t number_of_valid_positions = 0;
+    for(int i = 0; i < positions.cols(); i++)
+    {
+      double clearance = invalid_clearance;
+      number_of_valid_positions += sample(positions.col(i), clearance);
+      clearances(i) = clearance;
+    }
+    return number_of_valid_positions;
+  }
+  
+private:
+  const grid_map::Matrix& data_;
+  const Eigen::Vector2d top_left_corner_;
+  const double inverse_resolution_;
+  const double meters_per_unit_;
+  const Interpolation interpolation_;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DYNAMIC_CLEARANCE_MAP_H
+#define DYNAMIC_CLEARANCE_MAP_H
+
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <functional>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+// incrementally updated euclidean distance map (dynamic brushfire)
+// ref: B. Lau, C. Sprunk and W. Burgard, "Improved updating of Euclidean distance maps and Voronoi diagrams", IROS 2010
+// cells keep their nearest obstacle; only cells whose nearest obstacle appeared or vanished are updated
+class DynamicClearanceMap
+{
+public:
+  DynamicClearanceMap();
+  ~DynamicClearanceMap();
+  
+  bool isInitialized() const;
+  size_t getRows() const;
+  size_t getCols() const;
+  bool hasObstacle() const;
+  
+  // from scratch; cells whose cost > 0.01 are obstacles
+  void initialize(const grid_map::Matrix& costmap_data);
+  
+  // grid contents move by (shift_rows, shift_cols): cell (r, c) becomes (r + shift_rows, c + shift_cols)
+  // cells entering the map are free
+  void shift(const int shift_rows, const int shift_cols);
+  
+  // register cells whose occupancy differs from costmap_data; returns number of changed cells
+  // costmap_data has to have the same size as the initialized map
+  size_t setCostmap(const grid_map::Matrix& costmap_data);
+  
+  // propagate registered changes
+  void update();
+  
+  // distance in cells as ClearanceMapGenerator; 1 everywhere if there is no obstacle
+  void getClearanceMap(grid_map::Matrix& clearance_data) const;
+  
+private:
+  typedef std::pair<float, int> QueueElement;
+  
+  int rows_;
+  int cols_;
+  size_t number_of_obstacles_;
+  std::vector<float> distance_;
+  std::vector<int> nearest_obstacle_;
+  std::vector<uint8_t> is_occupied_;
+  std::vector<uint8_t> to_raise_;
+  std::priority_queue<QueueElement, std::vector<QueueElement>, std::greater<QueueElement>> open_queue_;
+  
+  void setObstacle(const int index);
+  void removeObstacle(const int index);
+  void clearCell(const int index);
+  void lower(const int index);
+  void raise(const int index);
+  float calculateDistance(const int index1, const int index2) const;
+  
+  template <typename Function>
+  void forEachNeighbor(const int index, Function function) const
+  {
+    const int row = index % rows_;
+    const int col = index / rows_;
+    for(int d_col = -1; d_col <= 1; d_col++)
+    {
+      const int neighbor_col = col + d_col;
+      if(neighbor_col < 0 || neighbor_col >= cols_)
+      {
+        continue;
+      }
+      for(int d_row = -1; d_row <= 1; d_row++)
+      {
+        const int neighbor_row = row + d_row;
+        if((d_row == 0 && d_col == 0) || neighbor_row < 0 || neighbor_row >= rows_)
+        {
+          continue;
+        }
+        function(neighbor_row + neighbor_col*rows_);
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ELASTIC_BAND_SMOOTHER_H
+#define ELASTIC_BAND_SMOOTHER_H
+
+#include <vector>
+
+//headers in Eigen
+#include <Eigen/Core>
+
+struct ElasticBandStatistics
+{
+  size_t number_of_iterations;
+  bool is_converged;
+  double elapsed_second;
+};
+
+// elastic band over a bubble path
+// every iteration minimizes sum |x[i-1] - 2x[i] + x[i+1]|^2 + anchor_weight*sum |x[i] - previous x[i]|^2,
+// a pentadiagonal system factorized once and solved in O(n), then projects each point into its bound:
+// the disc around its bubble center of radius (bubble clearance - min_r)
+// the first and the last point are fixed
+class ElasticBandSmoother
+{
+public:
+  ElasticBandSmoother(const double anchor_weight,
+                      const size_t max_iterations,
+                      const double convergence_distance);
+  ~ElasticBandSmoother();
+  
+  // bound_radii: how far each point may move from its center
+  // returns false if there are less than 3 points; points are the centers then
+  bool smooth(const std::vector<Eigen::Vector2d>& centers,
+              const std::vector<double>& bound_radii,
+              std::vector<Eigen::Vector2d>& points);
+  
+  const ElasticBandStatistics& getStatistics() const;
+  
+private:
+  const double anchor_weight_;
+  const size_t max_iterations_;
+  const double convergence_distance_;
+  ElasticBandStatistics statistics_;
+  
+  // LDL^T of the free points; l1[i] = L(i, i-1), l2[i] = L(i, i-2)
+  std::vector<double> d_;
+  std::vector<double> l1_;
+  std::vector<double> l2_;
+  
+  void factorize(const size_t number_of_free_points);
+  void solve(std::vector<double>& b) const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRENET_GEOMETRY_H
+#define FRENET_GEOMETRY_H
+
+#include <cmath>
+
+// scalar type used by the planner kernels; select with -DFRENET_PLANNER_USE_SINGLE_PRECISION=ON
+#ifdef FRENET_PLANNER_USE_SINGLE_PRECISION
+typedef float PlannerScalar;
+#else
+typedef double PlannerScalar;
+#endif
+
+// kernels work on differences relative to a lane point or waypoint;
+// absolute map coordinates stay in double so that float does not lose centimetres far from the origin
+// only these kernels and LateralPolynomial use PlannerScalar; the candidate and cost loops
+// of FrenetPlanner and the trajectory points they build stay double
+
+template <typename Scalar>
+inline Scalar calculate2DDistance(const Scalar dx, const Scalar dy)
+{
+  return std::sqrt(dx*dx + dy*dy);
+}
+
+template <typename Scalar>
+inline bool isWithin2DRadius(const Scalar dx, const Scalar dy, const Scalar radius)
+{
+  return dx*dx + dy*dy < radius*radius;
+}
+
+// offset from a lane point: delta_s along lane_yaw, then frenet_d to the right of lane_yaw
+template <typename Scalar>
+inline void calculateFrenetOffset(const Scalar lane_yaw,
+                                  const Scalar delta_s,
+                                  const Scalar frenet_d,
+                                  Scalar& offset_x,
+                                  Scalar& offset_y)
+{
+  const Scalar cos_yaw = std::cos(lane_yaw);
+  const Scalar sin_yaw = std::sin(lane_yaw);
+  // cos(yaw - pi/2) = sin(yaw), sin(yaw - pi/2) = -cos(yaw)
+  offset_x = delta_s*cos_yaw + frenet_d*sin_yaw;
+  offset_y = delta_s*sin_yaw - frenet_d*cos_yaw;
+}
+
+// same as calculateFrenetOffset but follows the arc of constant lane_curvature for delta_s,
+// so that sparse center lines keep their accuracy between points
+// yaw of the lane at delta_s is returned in arc_yaw
+template <typename Scalar>
+inline void calculateFrenetOffsetOnArc(const Scalar lane_yaw,
+                                       const Scalar lane_curvature,
+                                       const Scalar delta_s,
+                                       const Scalar frenet_d,
+                                       Scalar& offset_x,
+                                       Scalar& offset_y,
+                                       Scalar& arc_yaw)
+{
+  const Scalar delta_yaw = lane_curvature*delta_s;
+  const Scalar half_delta_yaw = delta_yaw/2;
+  // chord = delta_s*sin(half)/half; series for small angles avoids 0/0
+  Scalar chord_ratio = 1 - half_delta_yaw*half_delta_yaw/6;
+  if(std::abs(half_delta_yaw) > static_cast<Scalar>(1e-3))
+  {
+    chord_ratio = std::sin(half_delta_yaw)/half_delta_yaw;
+  }
+  const Scalar chord_length = delta_s*chord_ratio;
+  const Scalar chord_yaw = lane_yaw + half_delta_yaw;
+  arc_yaw = lane_yaw + delta_yaw;
+  offset_x = chord_length*std::cos(chord_yaw) + frenet_d*std::sin(arc_yaw);
+  offset_y = chord_length*std::sin(chord_yaw) - frenet_d*std::cos(arc_yaw);
+}
+
+#endif
@@ -19,20 +19,19 @@
 
 
 #include <geometry_msgs/TransformStamped.h>
+#include <autoware_msgs/Lane.h>
+#include <autoware_msgs/DetectedObjectArray.h>
 
 
 //headers in Eigen
 #include <Eigen/Core>
 
+#include "array_view.h"
 
-struct Point;
 
+struct Point;
+class WorkerPool;
 
-namespace autoware_msgs
-{
-  ROS_DECLARE_MESSAGE(Lane); 
-  ROS_DECLARE_MESSAGE(DetectedObjectArray); 
-}
 
 struct FrenetPoint
 {
@@ -85,9 +84,52 @@ struct Trajectory
   double required_time;
 };
 
+// input of a single planning call; points to caller-owned data which has to outlive the call
+struct PlanningInput
+{
+  const geometry_msgs::PoseStamped* current_pose;
+  const geometry_msgs::TwistStamped* current_twist;
+  // usually the part of the center line and reference path ahead of the ego
+  ArrayView<Point> lane_points;
+  ArrayView<autoware_msgs::Waypoint> reference_waypoints;
+  // nullptr if no objects are detected
+  const autoware_msgs::DetectedObjectArray* objects;
+  // fill PlanningOutput::debug_trajectories; skipped when nobody looks at them
+  bool collects_debug_trajectories;
+};
 
+struct PlanningOutput
+{
+  bool is_valid;
+  autoware_msgs::Lane trajectory;
+  std::vector<autoware_msgs::Lane> debug_trajectories;
+  std::vector<geometry_msgs::Point> reference_points;
+  // reason of failure instead of writing to std::cerr;
+  // may also hold a warning when is_valid is true
+  std::string error_message;
+};
+
+// self-contained scenario for batch planning
+struct PlanningScenario
+{
+  geometry_msgs::PoseStamped current_pose;
+  geometry_msgs::TwistStamped current_twist;
+  std::vector<Point> lane_points;
+  std::vector<autoware_msgs::Waypoint> reference_waypoints;
+  bool has_objects;
+  autoware_msgs::DetectedObjectArray objects;
+};
+
+struct BatchPlanningResult
+{
+  std::vector<PlanningOutput> outputs;
+  double elapsed_second;
+  double scenarios_per_second;
+};
 
 
+
+// configuration is fixed at construction; all planning methods are const and reentrant
 class FrenetPlanner
 {
 public:
@@ -106,155 +148,179 @@ public:
     double comfort_acceleration_cost_coef,
     double lookahead_distance_per_ms_for_reference_point,
     double converge_distance_per_ms_for_stopline,
-    double linear_velocity);
+    double linear_velocity,
+    const std::shared_ptr<WorkerPool>& worker_pool_ptr);
   ~FrenetPlanner();
   
   
-  void doPlan(const geometry_msgs::PoseStamped& in_current_pose,
+  bool plan(const PlanningInput& input, PlanningOutput& output) const;
+  
+  // spread scenarios across the worker pool; outputs are in the same order as scenarios
+  BatchPlanningResult planBatch(const std::vector<PlanningScenario>& scenarios,
+                                const bool collects_debug_trajectories) const;
+  
+  bool doPlan(const geometry_msgs::PoseStamped& in_current_pose,
               const geometry_msgs::TwistStamped& in_current_twist,
               const std::vector<Point>& in_nearest_lane_points,
               const std::vector<autoware_msgs::Waypoint>& in_reference_waypoints,
               const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
               autoware_msgs::Lane& out_trajectory,
               std::vector<autoware_msgs::Lane>& out_debug_trajectories,
-              std::vector<geometry_msgs::Point>& out_reference_points);
+              std::vector<geometry_msgs::Point>& out_reference_points,
+              std::string& out_error_message) const;
+  
+  // plan against every reference line (e.g. current and adjacent lanes) concurrently
+  // and output the path with the lowest cost among them
+  bool doPlan(const geometry_msgs::PoseStamped& in_current_pose,
+              const geometry_msgs::TwistStamped& in_current_twist,
+              const std::vector<std::vector<Point>>& in_reference_lines,
+              const std::vector<autoware_msgs::Waypoint>& in_reference_waypoints,
+              const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
+              autoware_msgs::Lane& out_trajectory,
+              std::vector<autoware_msgs::Lane>& out_debug_trajectories,
+              std::vector<geometry_msgs::Point>& out_reference_points,
+              size_t& out_selected_reference_line_index,
+              std::string& out_error_message) const;
   
   
 private:
   
   //initialize with rosparam
-  double initial_velocity_ms_;
-  double velcity_ms_before_obstalcle_;
-  double distance_before_obstalcle_;
-  double obstacle_radius_from_center_point_;
-  double min_lateral_referencing_offset_for_avoidance_;
-  double max_lateral_referencing_offset_for_avoidance_;
-  double diff_waypoints_cost_coef_;
-  double diff_last_waypoint_cost_coef_;
-  double jerk_cost_coef_;
-  double required_time_cost_coef_;
-  double comfort_acceleration_cost_coef_;
+  const double initial_velocity_ms_;
+  const double velcity_ms_before_obstalcle_;
+  const double distance_before_obstalcle_;
+  const double obstacle_radius_from_center_point_;
+  const double min_lateral_referencing_offset_for_avoidance_;
+  const double max_lateral_referencing_offset_for_avoidance_;
+  const double diff_waypoints_cost_coef_;
+  const double diff_last_waypoint_cost_coef_;
+  const double jerk_cost_coef_;
+  const double required_time_cost_coef_;
+  const double comfort_acceleration_cost_coef_;
   
-  double lookahead_distance_per_ms_for_reference_point_;
-  double minimum_lookahead_distance_for_reference_point_;
-  double lookahead_distance_for_reference_point_;
+  const double lookahead_distance_per_ms_for_reference_point_;
+  const double minimum_lookahead_distance_for_reference_point_;
+  const double lookahead_distance_for_reference_point_;
   
-  double converge_distance_per_ms_for_stop_;
-  double radius_from_reference_point_for_valid_trajectory_;
-  double dt_for_sampling_points_;
+  const double converge_distance_per_ms_for_stop_;
+  const double radius_from_reference_point_for_valid_trajectory_;
+  const double dt_for_sampling_points_;
   
-  double linear_velocity_;
-  // TODO: think better name previous_best_trajectoy?
-  std::unique_ptr<Trajectory> kept_current_trajectory_;
-  std::unique_ptr<Trajectory> kept_next_trajectory_;
+  const double linear_velocity_;
   
+  // shared between planners; nullptr at construction creates one thread per core
+  std::shared_ptr<WorkerPool> worker_pool_ptr_;
   
-  std::unique_ptr<ReferencePoint> kept_current_reference_point_;
-  std::unique_ptr<ReferencePoint> kept_next_reference_point_;
-  
-  std::unique_ptr<std::vector<autoware_msgs::Waypoint>> previous_best_path_;
+  double calculatePathCost(
+    const std::vector<autoware_msgs::Waypoint>& path,
+    const ArrayView<autoware_msgs::Waypoint>& reference_waypoints) const;
   
   bool generateEntirePath(
     const geometry_msgs::PoseStamped& current_pose,
-    const std::vector<Point>& lane_points,
-    const std::vector<autoware_msgs::Waypoint>& reference_waypoints,
-    const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
+    const ArrayView<Point>& lane_points,
+    const ArrayView<autoware_msgs::Waypoint>& reference_waypoints,
+    const autoware_msgs::DetectedObjectArray* objects_ptr,
     std::vector<autoware_msgs::Waypoint>& path_points,
-    std::vector<autoware_msgs::Lane>& out_debug_trajectories,
-    std::vector<geometry_msgs::Point>& out_reference_points
-    );
+    std::vector<autoware_msgs::Lane>* out_debug_trajectories,
+    std::vector<geometry_msgs::Point>& out_reference_points,
+    std::string& error_message
+    ) const;
 
-  void  getNearestPoints(const geometry_msgs::Point& point,
-                        const std::vector<Point>& nearest_lane_points,
+  bool getNearestPoints(const geometry_msgs::Point& point,
+                        const ArrayView<Point>& nearest_lane_points,
                         Point& nearest_point,
-                        Point& second_nearest_point);
+                        Point& second_nearest_point) const;
                         
   void  getNearestPoint(const geometry_msgs::Point& point,
-                        const std::vector<Point>& nearest_lane_points,
-                        Point& nearest_point);
+                        const ArrayView<Point>& nearest_lane_points,
+                        Point& nearest_point) const;
   
   void getNearestWaypoint(const geometry_msgs::Point& point,
-                          const  std::vector<autoware_msgs::Waypoint>& waypoints,
-                          autoware_msgs::Waypoint& nearest_waypoint);
+                          const ArrayView<autoware_msgs::Waypoint>& waypoints,
+                          autoware_msgs::Waypoint& nearest_waypoint) const;
                         
   void getNearestWaypoints(const geometry_msgs::Pose& point,
                           const autoware_msgs::Lane& waypoints,
                           autoware_msgs::Waypoint& nearest_waypoint,
-                          autoware_msgs::Waypoint& second_nearest_waypoint);
+                          autoware_msgs::Waypoint& second_nearest_waypoint) const;
                
+  template <int PolynomialDegree, int NumSample>
   bool generateTrajectory(
     const geometry_msgs::Pose& ego_pose,
-    const std::vector<Point>& lane_points,
-    const std::vector<autoware_msgs::Waypoint>& reference_waypoints,  
+    const ArrayView<Point>& lane_points,
+    const ArrayView<autoware_msgs::Waypoint>& reference_waypoints,  
     const FrenetPoint& origin_frenet_point,
     const FrenetPoint& reference_freent_point,
     const double time_horizon,
     const double dt_for_sampling_points, 
-    Trajectory& trajectory);
+    Trajectory& trajectory) const;
     
     
-  bool calculateWaypoint(const std::vector<Point>& lane_points, 
+  bool calculateWaypoint(const ArrayView<Point>& lane_points, 
                         const FrenetPoint& frenet_point,
-                        autoware_msgs::Waypoint& waypoint);
+                        autoware_msgs::Waypoint& waypoint) const;
   
-  bool calculateTrajectoryPoint(const std::vector<Point>& lane_points, 
+  bool calculateTrajectoryPoint(const ArrayView<Point>& lane_points, 
                            const FrenetPoint& frenet_point,
-                           TrajecotoryPoint& waypoint);
+                           TrajecotoryPoint& waypoint) const;
   
   //TODO: think better name for delta_s
-  //TODO: improbe by changing delta_yaw(reference current or previous)
+  // delta_yaw and curvature are the nearest lane point's yaw and curvature;
+  // position follows the arc of that curvature so that sparse center lines stay accurate
   bool convertFrenetPosition2CartesianPosition(
                            const double frenet_s,
                            const double frenet_d,
                            const geometry_msgs::Point& nearest_lane_cartesian_point,
                            const double delta_s,
                            const double delta_yaw,
-                           geometry_msgs::Point& waypoint_position);
+                           const double curvature,
+                           geometry_msgs::Point& waypoint_position,
+                           double& lane_yaw_at_waypoint) const;
                            
   bool convertCartesianPosition2FrenetPosition(
         const geometry_msgs::Point& cartesian_point,
-        const std::vector<Point> lane_points,        
+        const ArrayView<Point>& lane_points,        
         double& frenet_s_position,
-        double& frenet_d_position);
+        double& frenet_d_position) const;
         
   bool selectBestTrajectory(
     const std::vector<Trajectory>& trajectories,
-    const std::unique_ptr<autoware_msgs::DetectedObjectArray>& objects_ptr,
-    const std::vector<autoware_msgs::Waypoint>& cropped_reference_waypoints,
+    const autoware_msgs::DetectedObjectArray* objects_ptr,
+    const ArrayView<autoware_msgs::Waypoint>& cropped_reference_waypoints,
     std::unique_ptr<ReferencePoint>& kept_reference_point,    
-    std::unique_ptr<Trajectory>& kept_best_trajectory);
+    std::unique_ptr<Trajectory>& kept_best_trajectory) const;
   
   bool isCollision(const autoware_msgs::Waypoint& waypoint,
-                   const autoware_msgs::DetectedObjectArray& objects);
+                   const autoware_msgs::DetectedObjectArray& objects) const;
                    
   bool isCollision(const autoware_msgs::Waypoint& waypoint,
                    const autoware_msgs::DetectedObjectArray& objects,
                    size_t& collision_object_id,
-                   size_t& collision_object_index);
+                   size_t& collision_object_index) const;
                       
   bool drawTrajectories(
               const geometry_msgs::Pose& ego_pose,
               const FrenetPoint& frenet_current_point,
               const ReferencePoint& reference_point,
-              const std::vector<Point>& in_nearest_lane_points,
-              const std::vector<autoware_msgs::Waypoint>& in_reference_waypoints,
+              const ArrayView<Point>& in_nearest_lane_points,
+              const ArrayView<autoware_msgs::Waypoint>& in_reference_waypoints,
               std::vector<Trajectory>& trajectories,
-              std::vector<autoware_msgs::Lane>& out_debug_trajectories);
+              std::vector<autoware_msgs::Lane>* out_debug_trajectories) const;
     
   bool isTrajectoryCollisionFree(
     const std::vector<autoware_msgs::Waypoint>& trajectory_points,
     const autoware_msgs::DetectedObjectArray& objects,
     size_t& collision_waypoint_index,
     size_t& collision_object_id,
-    size_t& collision_object_index);
+    size_t& collision_object_index) const;
     
   bool isTrajectoryCollisionFree(
     const std::vector<autoware_msgs::Waypoint>& trajectory_points,
-    const autoware_msgs::DetectedObjectArray& objects);
+    const autoware_msgs::DetectedObjectArray& objects) const;
     
   void getNearestWaypointIndex(const geometry_msgs::Point& point,
-                                    const std::vector<autoware_msgs::Waypoint>& waypoints,
-                                    size_t& nearest_waypoint_index);
+                                    const ArrayView<autoware_msgs::Waypoint>& waypoints,
+                                    size_t& nearest_waypoint_index) const;
 };
 
 #endif
@@ -17,7 +17,21 @@
 #ifndef FRENET_PLANNER_ROS_H
 #define FRENET_PLANNER_ROS_H
 
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <mutex>
+
+#include "latest_value_mailbox.h"
+
 struct Point;
+struct ReferencePath;
+struct ReferencePathRequest;
+struct CostmapInput;
+struct DebugOutput;
+struct PlanningOutput;
 
 namespace tf2_ros
 {
@@ -29,6 +43,9 @@ class FrenetPlanner;
 class VectorMap;
 class CalculateCenterLine;
 class ModifiedReferencePathGenerator;
+class ProgressTracker;
+class PlanningTrigger;
+class LatencyStatistics;
 
 namespace autoware_msgs
 {
@@ -37,6 +54,16 @@ namespace autoware_msgs
   ROS_DECLARE_MESSAGE(Waypoint); 
 }
 
+namespace visualization_msgs
+{
+  ROS_DECLARE_MESSAGE(MarkerArray); 
+}
+
+namespace sensor_msgs
+{
+  ROS_DECLARE_MESSAGE(PointCloud2); 
+}
+
 namespace grid_map_msgs
 {
   ROS_DECLARE_MESSAGE(GridMap); 
@@ -58,7 +85,10 @@ class FrenetPlannerROS
 {
 public:
 
+  // node handles of the standalone node
   FrenetPlannerROS();
+  // private_nh holds the parameters; used by the nodelet
+  FrenetPlannerROS(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
   ~FrenetPlannerROS();
   void run();
 
@@ -77,30 +107,72 @@ private:
   bool use_global_waypoints_as_center_line_;
   bool has_calculated_center_line_from_global_waypoints_;
   
-  //TODO: not 
-  bool got_modified_reference_path_;
   bool only_testing_modified_global_path_;
+  // regenerate the modified reference path every cycle, reusing its still valid part
+  bool use_receding_horizon_reference_path_;
+  // objects farther than this from the reference path ahead are not passed to the planner; 0 passes all
+  double object_corridor_margin_;
   
-  //TODO: not good code
-  std::vector<autoware_msgs::Waypoint> modified_reference_path_;
-  std::vector<Point> center_line_points_;
-  // std::vector<autoware_msgs::Waypoint> debug_bspline_path_;
+  // latest completed reference path; nullptr until the first success
+  // swapped with std::atomic_store so that planning never waits for generation
+  std::shared_ptr<const ReferencePath> reference_path_ptr_;
+  // latest inputs for the reference path thread
+  std::shared_ptr<const ReferencePathRequest> reference_path_request_ptr_;
+  // not joinable when the reference path is generated in the planning cycle
+  std::thread reference_path_thread_;
+  // last costmap converted for the reference path; holds clearance after generation
+  std::unique_ptr<grid_map::GridMap> clearance_map_ptr_;
+  uint32_t last_costmap_seq_;
+  ros::Time last_costmap_stamp_;
+  // not joinable when planning runs in timerCallback
+  std::thread planning_thread_;
+  // nullptr unless planning is started by pose and objects callbacks
+  std::unique_ptr<PlanningTrigger> planning_trigger_ptr_;
+  std::atomic<bool> is_shutdown_;
   
   ros::Timer timer_;
+  // timer callbacks run on a multi-threaded queue; a tick is skipped while the previous cycle still runs
+  std::mutex timer_planning_mutex_;
   
   
   std::unique_ptr<tf2_ros::Buffer> tf2_buffer_ptr_;
   std::unique_ptr<tf2_ros::TransformListener> tf2_listner_ptr_;
-  std::unique_ptr<geometry_msgs::TransformStamped> lidar2map_tf_;
-  std::unique_ptr<geometry_msgs::TransformStamped> map2lidar_tf_;
   
   
+  // callbacks only post here; each planning cycle loads one snapshot of all of them
+  LatestValueMailbox<autoware_msgs::Lane> waypoints_mailbox_;
+  LatestValueMailbox<geometry_msgs::PoseStamped> pose_mailbox_;
+  LatestValueMailbox<geometry_msgs::TwistStamped> twist_mailbox_;
+  // objects in the frame of waypoints
+  LatestValueMailbox<autoware_msgs::DetectedObjectArray> objects_mailbox_;
+  LatestValueMailbox<CostmapInput> costmap_mailbox_;
+  
+  // nearest points to the ego on the global waypoints, reference path and center line
+  std::unique_ptr<ProgressTracker> waypoints_tracker_ptr_;
+  std::unique_ptr<ProgressTracker> reference_path_tracker_ptr_;
+  std::unique_ptr<ProgressTracker> center_line_tracker_ptr_;
+  
+  // objects passed to the planner when culling by object_corridor_margin_
+  std::unique_ptr<autoware_msgs::DetectedObjectArray> corridor_objects_ptr_;
+  
+  // debug markers and clearance point cloud are published by debug_thread_
+  // at this period when positive, otherwise where they are made
+  double debug_publish_delta_second_;
+  std::thread debug_thread_;
+  LatestValueMailbox<DebugOutput> debug_output_mailbox_;
+  LatestValueMailbox<sensor_msgs::PointCloud2> debug_pointcloud_mailbox_;
+  std::chrono::steady_clock::time_point last_debug_pointcloud_time_;
+  
+  // age of the pose and objects at trajectory publish
+  std::unique_ptr<LatencyStatistics> pose_latency_statistics_ptr_;
+  std::unique_ptr<LatencyStatistics> objects_latency_statistics_ptr_;
   
-  std::unique_ptr<autoware_msgs::Lane> in_waypoints_ptr_;
-  std::unique_ptr<geometry_msgs::PoseStamped> in_pose_ptr_;
-  std::unique_ptr<geometry_msgs::TwistStamped> in_twist_ptr_;
-  std::unique_ptr<autoware_msgs::DetectedObjectArray> in_objects_ptr_;
-  std::unique_ptr<grid_map_msgs::GridMap> in_gridmap_ptr_;
+  // output messages reused every planning cycle
+  std::unique_ptr<autoware_msgs::Lane> out_lane_ptr_;
+  std::unique_ptr<visualization_msgs::MarkerArray> out_marker_array_ptr_;
+  // planner output refilled in place; its waypoints are swapped with out_lane_ptr_'s,
+  // so that both buffers keep their capacity
+  std::unique_ptr<PlanningOutput> planning_output_ptr_;
   
   std::unique_ptr<FrenetPlanner> frenet_planner_ptr_;
   std::unique_ptr<VectorMap> vectormap_load_ptr_;
@@ -108,12 +180,24 @@ private:
   std::unique_ptr<ModifiedReferencePathGenerator> modified_reference_path_generator_ptr_;
   std::unique_ptr<std::vector<Point>> global_center_points_ptr_;
   
-  void waypointsCallback(const autoware_msgs::Lane& msg);
-  void currentPoseCallback(const geometry_msgs::PoseStamped& msg);
-  void currentVelocityCallback(const geometry_msgs::TwistStamped& msg);
-  void objectsCallback(const autoware_msgs::DetectedObjectArray& msg);
-  void gridmapCallback(const grid_map_msgs::GridMap& msg);
+  void waypointsCallback(const autoware_msgs::LaneConstPtr& msg);
+  void currentPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg);
+  void currentVelocityCallback(const geometry_msgs::TwistStampedConstPtr& msg);
+  void objectsCallback(const autoware_msgs::DetectedObjectArrayConstPtr& msg);
+  void gridmapCallback(const grid_map_msgs::GridMapConstPtr& msg);
   void timerCallback(const ros::TimerEvent &e);
+  void runPlanningCycle();
+  // call cycle every delta_second until shutdown; missed cycles are skipped
+  void runAtRate(const double delta_second, const std::function<void()>& cycle);
+  bool needsReferencePathGeneration() const;
+  // generate from request and publish the result to reference_path_ptr_ on success
+  bool generateReferencePath(const ReferencePathRequest& request);
+  void referencePathThreadLoop(const double delta_second);
+  void planningThreadLoop(const double delta_second);
+  void eventDrivenPlanningLoop();
+  // publish the latest posted debug output at most once per delta_second, at idle priority
+  void debugThreadLoop(const double delta_second);
+  void publishDebugMarkers(const DebugOutput& debug_output);
   void loadVectormap();
   Point getNearestPoint(const geometry_msgs::PoseStamped& ego_pose);
 
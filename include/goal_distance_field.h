@@ -0,0 +1,78 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GOAL_DISTANCE_FIELD_H
+#define GOAL_DISTANCE_FIELD_H
+
+#include <vector>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+//headers in Eigen
+#include <Eigen/Core>
+
+// distance to the goal around obstacles on a downsampled clearance map (8-connected dijkstra)
+// used as A* heuristic so that the search does not flood dead ends behind u-shaped obstacles
+class GoalDistanceField
+{
+public:
+  // downsample: number of fine cells per coarse cell side
+  GoalDistanceField(const int downsample, const double min_r);
+  ~GoalDistanceField();
+  
+  // clearance_data is the clearance layer starting at index (0, 0); value*clearance_to_m is in metres
+  // a coarse cell is free if any of its fine cells has clearance of min_r/2 or more
+  void compute(const grid_map::Matrix& clearance_data,
+               const grid_map::Position& map_position,
+               const double resolution,
+               const double clearance_to_m,
+               const Eigen::Vector2d& goal_p,
+               const grid_map::Time timestamp,
+               const size_t roi_key);
+  
+  // whether compute was already called for this goal and map
+  // roi_key identifies the region the clearance was computed in, since clearance outside of it is saturated
+  bool isComputedFor(const Eigen::Vector2d& goal_p,
+                     const grid_map::Time timestamp,
+                     const size_t roi_key) const;
+  
+  // lower bound of the path length from position to the goal; never less than the euclidean distance
+  // infinity if the goal cannot be reached from position
+  double getHeuristic(const Eigen::Vector2d& position) const;
+  
+  size_t getNumberOfVisitedCells() const;
+  
+private:
+  const int downsample_;
+  const double min_r_;
+  
+  int rows_;
+  int cols_;
+  double coarse_resolution_;
+  // corner of max x and max y; index grows as x and y decrease
+  Eigen::Vector2d top_left_corner_;
+  Eigen::Vector2d goal_p_;
+  grid_map::Time timestamp_;
+  size_t roi_key_;
+  bool is_computed_;
+  bool is_goal_on_map_;
+  size_t number_of_visited_cells_;
+  std::vector<double> distance_;
+  
+  bool getCoarseIndex(const Eigen::Vector2d& position, int& row, int& col) const;
+};
+
+#endif
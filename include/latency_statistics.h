@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATENCY_STATISTICS_H
+#define LATENCY_STATISTICS_H
+
+#include <vector>
+#include <string>
+
+// distribution of latency samples, reported and restarted every report_interval samples
+class LatencyStatistics
+{
+public:
+  LatencyStatistics(const std::string& name, const size_t report_interval);
+  ~LatencyStatistics();
+  
+  // returns true when report_interval samples are collected and a new report is ready
+  bool add(const double latency_second);
+  
+  // percentiles of the last completed interval; logging is left to the caller
+  const std::string& getReport() const;
+  
+private:
+  const std::string name_;
+  const size_t report_interval_;
+  std::vector<double> samples_;
+  std::string report_;
+  
+  void updateReport();
+};
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATERAL_POLYNOMIAL_H
+#define LATERAL_POLYNOMIAL_H
+
+//headers in Eigen
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+// k-th derivative coefficient of s^power: power!/(power-k)!
+// becomes 0 when order > power
+constexpr double fallingFactorial(const int power, const int order)
+{
+  return order == 0 ? 1.0 : power*fallingFactorial(power - 1, order - 1);
+}
+
+template <int... Indices>
+struct IndexSequence
+{
+};
+
+template <int Size, int... Indices>
+struct MakeIndexSequence : MakeIndexSequence<Size - 1, Size - 1, Indices...>
+{
+};
+
+template <int... Indices>
+struct MakeIndexSequence<0, Indices...>
+{
+  typedef IndexSequence<Indices...> type;
+};
+
+// fallingFactorial(power, order) at [order*NumPowers + power], evaluated at compile time
+template <int NumOrders, int NumPowers, typename Sequence = typename MakeIndexSequence<NumOrders*NumPowers>::type>
+struct DerivativeCoefficientTable;
+
+template <int NumOrders, int NumPowers, int... Indices>
+struct DerivativeCoefficientTable<NumOrders, NumPowers, IndexSequence<Indices...>>
+{
+  static constexpr double values[NumOrders*NumPowers] = {fallingFactorial(Indices % NumPowers, Indices / NumPowers)...};
+};
+
+template <int NumOrders, int NumPowers, int... Indices>
+constexpr double DerivativeCoefficientTable<NumOrders, NumPowers, IndexSequence<Indices...>>::values[NumOrders*NumPowers];
+
+// lateral offset d(delta_s) = c0 + c1*delta_s + ... + cN*delta_s^N
+// start: d = origin_d, d' = start_slope, higher derivatives up to (N-1)/2 are 0
+// end:   d = target_d, derivatives up to (N-1)/2 are 0
+template <int Degree, typename Scalar = double>
+class LateralPolynomial
+{
+  static_assert(Degree >= 3 && Degree % 2 == 1, "degree of lateral polynomial should be odd and >= 3");
+
+public:
+  static constexpr int NumCoefficients = Degree + 1;
+  static constexpr int NumBoundaryConditions = (Degree + 1)/2;
+
+  LateralPolynomial(const Scalar origin_d,
+                    const Scalar start_slope,
+                    const Scalar target_d,
+                    const Scalar delta_s)
+  {
+    coefficients_.setZero();
+    coefficients_(0) = origin_d;
+    coefficients_(1) = start_slope;
+
+    typedef DerivativeCoefficientTable<NumBoundaryConditions, NumCoefficients> DerivativeCoefficients;
+    
+    // depends on delta_s, so this one is filled at run time
+    Scalar powers_of_delta_s[NumCoefficients];
+    powers_of_delta_s[0] = 1;
+    for(int j = 1; j < NumCoefficients; j++)
+    {
+      powers_of_delta_s[j] = powers_of_delta_s[j-1]*delta_s;
+    }
+
+    // unknowns are c_M .. c_N where M = NumBoundaryConditions
+    Eigen::Matrix<Scalar, NumBoundaryConditions, NumBoundaryConditions> a;
+    Eigen::Matrix<Scalar, NumBoundaryConditions, 1> b;
+    for(int k = 0; k < NumBoundaryConditions; k++)
+    {
+      b(k) = (k == 0) ? target_d : 0;
+      for(int j = 0; j < NumBoundaryConditions; j++)
+      {
+        b(k) -= static_cast<Scalar>(DerivativeCoefficients::values[k*NumCoefficients + j])*coefficients_(j)*(j >= k ? powers_of_delta_s[j-k] : 0);
+      }
+      for(int j = NumBoundaryConditions; j < NumCoefficients; j++)
+      {
+        a(k, j - NumBoundaryConditions) =
+          static_cast<Scalar>(DerivativeCoefficients::values[k*NumCoefficients + j])*powers_of_delta_s[j-k];
+      }
+    }
+    coefficients_.template tail<NumBoundaryConditions>() = a.partialPivLu().solve(b);
+  }
+
+  // Horner evaluation; loop length is known at compile time
+  Scalar evaluate(const Scalar delta_s) const
+  {
+    Scalar value = coefficients_(Degree);
+    for(int j = Degree - 1; j >= 0; j--)
+    {
+      value = value*delta_s + coefficients_(j);
+    }
+    return value;
+  }
+
+  // evaluate at NumSample points equally spaced in (0, delta_s]
+  template <int NumSample>
+  void sample(const Scalar delta_s,
+              Eigen::Matrix<Scalar, NumSample, 1>& sampled_delta_s,
+              Eigen::Matrix<Scalar, NumSample, 1>& sampled_d) const
+  {
+    for(int i = 0; i < NumSample; i++)
+    {
+      sampled_delta_s(i) = sampleFraction<NumSample>(i)*delta_s;
+      sampled_d(i) = evaluate(sampled_delta_s(i));
+    }
+  }
+
+  template <int NumSample>
+  static constexpr Scalar sampleFraction(const int sample_index)
+  {
+    return static_cast<Scalar>(sample_index + 1)/static_cast<Scalar>(NumSample);
+  }
+
+  const Eigen::Matrix<Scalar, NumCoefficients, 1>& coefficients() const
+  {
+    return coefficients_;
+  }
+
+private:
+  Eigen::Matrix<Scalar, NumCoefficients, 1> coefficients_;
+};
+
+typedef LateralPolynomial<3> CubicLateralPolynomial;
+typedef LateralPolynomial<5> QuinticLateralPolynomial;
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATEST_VALUE_MAILBOX_H
+#define LATEST_VALUE_MAILBOX_H
+
+#include <memory>
+#include <chrono>
+
+// holds only the newest value; a post replaces the previous one
+// and readers keep whatever they have loaded until they load again.
+// posting and loading swap a shared_ptr with std::atomic_store/std::atomic_load,
+// so neither side waits for the other to finish its work
+template <typename T>
+class LatestValueMailbox
+{
+public:
+  struct Letter
+  {
+    std::shared_ptr<const T> value;
+    std::chrono::steady_clock::time_point posted_time;
+  };
+
+  void post(const std::shared_ptr<const T>& value)
+  {
+    std::shared_ptr<Letter> letter_ptr = std::make_shared<Letter>();
+    letter_ptr->value = value;
+    letter_ptr->posted_time = std::chrono::steady_clock::now();
+    std::atomic_store(&letter_ptr_, std::shared_ptr<const Letter>(letter_ptr));
+  }
+
+  // nullptr until the first post
+  std::shared_ptr<const Letter> load() const
+  {
+    return std::atomic_load(&letter_ptr_);
+  }
+
+private:
+  std::shared_ptr<const Letter> letter_ptr_;
+};
+
+#endif
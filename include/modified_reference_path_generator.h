@@ -17,6 +17,9 @@
 #ifndef MODIFIED_REFERENCE_PATH_GENERATOR_H
 #define MODIFIED_REFERENCE_PATH_GENERATOR_H
 
+#include "clearance_sampler.h"
+#include "bubble_a_star.h"
+
 namespace autoware_msgs
 {
   ROS_DECLARE_MESSAGE(Waypoint); 
@@ -30,14 +33,50 @@ namespace grid_map
 namespace geometry_msgs
 { 
   ROS_DECLARE_MESSAGE(TransformStamped);
+  ROS_DECLARE_MESSAGE(Point);
 }
 
 struct PathPoint;
+class ClearanceMapGenerator;
+class GoalDistanceField;
+class TiledClearanceGrid;
+class ElasticBandSmoother;
+class RigidTransform;
 
 class ModifiedReferencePathGenerator
 {
 private:
   const double min_radius_;
+  const bool use_incremental_clearance_map_;
+  const bool use_clearance_roi_;
+  const bool use_adaptive_branching_;
+  const ClearanceSampler::Interpolation clearance_interpolation_;
+  std::unique_ptr<ClearanceMapGenerator> clearance_map_generator_ptr_;
+  // nullptr when the euclidean heuristic is used
+  std::unique_ptr<GoalDistanceField> goal_distance_field_ptr_;
+  // nullptr when the bubble search reads the float layer
+  std::unique_ptr<TiledClearanceGrid> tiled_clearance_grid_ptr_;
+  // nullptr when smoothing by moving points one at a time
+  std::unique_ptr<ElasticBandSmoother> elastic_band_smoother_ptr_;
+  const bool use_receding_horizon_;
+  // bubbles of the previous path in map frame; x, y and radius
+  std::vector<Eigen::Vector3d> previous_bubble_path_;
+  
+  // bubbles of the previous path ahead of start_p which are still free and connected,
+  // up to the first one overlapping the goal
+  void keepValidBubblePrefix(
+          const Eigen::Vector2d& start_p,
+          const double start_r,
+          const BubbleNode& goal_node,
+          const double max_r,
+          const BubbleAStar::ClearanceFunction& clearance_function,
+          const RigidTransform& map2lidar_transform,
+          std::vector<BubbleNode>& kept_bubbles);
+          
+  void storeBubblePath(
+          const std::vector<BubbleNode>& bubble_path,
+          const RigidTransform& lidar2map_transform);
+          
   bool calculateCurvatureForPathPoints(
             std::vector<PathPoint>& path_points);
   double calculateCurvatureFromThreePoints(
@@ -53,7 +92,7 @@ private:
           const Eigen::Vector2d& path_point1,
           const Eigen::Vector2d& path_point2,
           const Eigen::Vector2d& path_point3,
-          const grid_map::GridMap& clearance_map,
+          const ClearanceSampler& clearance_sampler,
           const double min_r,
           const double max_k,
           const double resolution_of_gridmap);
@@ -62,28 +101,65 @@ private:
      const int number_of_knot,
      const int degree_of_b_spline);
      
-  double calaculateBasisFunction(
+  size_t findKnotSpan(
      const std::vector<double>& knot_vector,
-     const size_t control_point_index,
-     const size_t basis_function_index,
+     const int degree_of_b_spline,
+     const size_t number_of_control_points,
+     const double function_value);
+     
+  Eigen::Vector2d evaluateBSpline(
+     const std::vector<PathPoint>& control_points,
+     const std::vector<double>& knot_vector,
+     const int degree_of_b_spline,
+     const size_t knot_span,
      const double function_value);
           
 public:
+  // distance_transform_num_threads: 0 means std::thread::hardware_concurrency()
+  // use_incremental_clearance_map: only propagate cells changed since the previous costmap
+  // use_clearance_roi: only compute clearance in the corridor along the reference path; ignored when incremental
+  // goal_distance_heuristic_downsample: cells per side of the goal distance field used as A* heuristic;
+  // 0 uses the euclidean distance
+  // use_adaptive_branching: vary the number of A* expansion directions with clearance
+  // use_bilinear_clearance: interpolate clearance between cells instead of taking the nearest cell
+  // use_tiled_clearance_grid: bubble search reads a tiled centimetre copy of the clearance (nearest cell only)
+  // elastic_band_max_iterations: smooth with the banded elastic band up to this many iterations;
+  // 0 uses the point-by-point smoothing
+  // use_receding_horizon: keep the still valid part of the previous bubble path and only search the rest
   ModifiedReferencePathGenerator(
-     const double min_radius);
+     const double min_radius,
+     const size_t distance_transform_num_threads,
+     const bool use_incremental_clearance_map,
+     const bool use_clearance_roi,
+     const int goal_distance_heuristic_downsample,
+     const bool use_adaptive_branching,
+     const bool use_bilinear_clearance,
+     const bool use_tiled_clearance_grid,
+     const int elastic_band_max_iterations,
+     const bool use_receding_horizon);
   ~ModifiedReferencePathGenerator();
   
+  // whether the clearance written into clearance_map by the previous call covers the whole map,
+  // so that it can be passed again with reuse_clearance_map while the costmap is unchanged
+  bool canReuseClearanceMap() const;
+  
+  // clearance_map: costmap in, clearance out
+  // reuse_clearance_map: clearance_map already holds the clearance of the previous call
+  // reference_points: reference path between start and goal in map frame; bounds the clearance corridor
+  // debug_pointcloud_clearance_map: nullptr skips converting the clearance to a point cloud
   bool generateModifiedReferencePath(
       grid_map::GridMap& clearance_map,
+      const bool reuse_clearance_map,
       const geometry_msgs::Point& start_point,
       const geometry_msgs::Point& goal_point,
+      const std::vector<geometry_msgs::Point>& reference_points,
       const geometry_msgs::TransformStamped& lidar2map_tf,
       const geometry_msgs::TransformStamped& map2lidar_tf,
       std::vector<autoware_msgs::Waypoint>& modified_reference_path,
       std::vector<autoware_msgs::Waypoint>& debug_a_star_path,
       std::vector<autoware_msgs::Waypoint>& debug_modified_smoothed_reference_path,      
       std::vector<autoware_msgs::Waypoint>& debug_bspline_path,      
-      sensor_msgs::PointCloud2& debug_pointcloud_clearance_map);
+      sensor_msgs::PointCloud2* debug_pointcloud_clearance_map);
 };
 
 
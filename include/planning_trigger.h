@@ -0,0 +1,56 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLANNING_TRIGGER_H
+#define PLANNING_TRIGGER_H
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// starts planning on input events instead of a fixed period;
+// events until the next start are coalesced into one, starts are at least min_delta_second apart,
+// and planning starts anyway when no event arrives for max_delta_second
+class PlanningTrigger
+{
+public:
+  PlanningTrigger(const double min_delta_second, const double max_delta_second);
+  ~PlanningTrigger();
+  
+  // called by input callbacks; never blocks on planning
+  void notify();
+  
+  // blocks until planning should start; false after shutdown
+  bool wait();
+  
+  // wakes up wait for good
+  void shutdown();
+  
+  // events coalesced into the last start; 0 if it started because max_delta_second passed
+  size_t getNumberOfCoalescedEvents() const;
+  
+private:
+  const std::chrono::steady_clock::duration min_period_;
+  const std::chrono::steady_clock::duration max_period_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  size_t number_of_pending_events_;
+  size_t number_of_coalesced_events_;
+  bool is_shutdown_;
+  std::chrono::steady_clock::time_point last_start_time_;
+};
+
+#endif
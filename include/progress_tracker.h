@@ -0,0 +1,53 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PROGRESS_TRACKER_H
+#define PROGRESS_TRACKER_H
+
+#include <memory>
+#include <functional>
+
+// index of the path point nearest to the ego, tracked over cycles:
+// the whole path is searched only when the path changes,
+// otherwise a window from the previous index and then forward while the distance keeps decreasing
+class ProgressTracker
+{
+public:
+  // backward_window: points behind the previous index searched against localization noise
+  // forward_window: points ahead of the previous index always searched
+  ProgressTracker(const size_t backward_window, const size_t forward_window);
+  ~ProgressTracker();
+  
+  // path_owner identifies the path; it is kept so that a new path never gets the same identity
+  // squared_distance(i): squared distance from the ego to point i
+  // returns path_size if the path is empty
+  size_t findNearestIndex(const std::shared_ptr<const void>& path_owner,
+                          const size_t path_size,
+                          const std::function<double(const size_t)>& squared_distance);
+  
+  // number of points evaluated by the last findNearestIndex
+  size_t getNumberOfVisitedPoints() const;
+  
+private:
+  const size_t backward_window_;
+  const size_t forward_window_;
+  std::shared_ptr<const void> path_owner_;
+  size_t path_size_;
+  size_t nearest_index_;
+  size_t number_of_visited_points_;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RIGID_TRANSFORM_H
+#define RIGID_TRANSFORM_H
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <geometry_msgs/Pose.h>
+
+// rigid transform converted once from a tf message,
+// so that whole arrays of points are transformed by one matrix product
+// instead of calling tf2::doTransform point by point
+class RigidTransform
+{
+public:
+  explicit RigidTransform(const geometry_msgs::TransformStamped& transform);
+  ~RigidTransform();
+  
+  // points are columns
+  void transformPoints(const Eigen::Matrix3Xd& points,
+                       Eigen::Matrix3Xd& transformed_points) const;
+  
+  // 2D points at the common height z; same as transforming (x, y, z)
+  void transformPoints(const Eigen::Matrix2Xd& points,
+                       const double z,
+                       Eigen::Matrix3Xd& transformed_points) const;
+  
+  Eigen::Vector3d transformPoint(const Eigen::Vector3d& point) const;
+  
+  geometry_msgs::Point transformPoint(const geometry_msgs::Point& point) const;
+  
+  geometry_msgs::Quaternion transformOrientation(const geometry_msgs::Quaternion& orientation) const;
+  
+  geometry_msgs::Pose transformPose(const geometry_msgs::Pose& pose) const;
+  
+private:
+  Eigen::Quaterniond rotation_;
+  Eigen::Matrix3d rotation_matrix_;
+  Eigen::Vector3d translation_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TILED_CLEARANCE_GRID_H
+#define TILED_CLEARANCE_GRID_H
+
+#include <vector>
+#include <cstdint>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+//headers in Eigen
+#include <Eigen/Core>
+
+// compact copy of a clearance layer for the bubble search:
+// clearance is quantized to centimetres in uint16 and stored in 8x4 cell tiles of one 64 byte cache line,
+// so that lookups around a bubble touch few lines
+// index convention is the same as ClearanceSampler
+class TiledClearanceGrid
+{
+public:
+  static constexpr int TILE_ROWS = 8;
+  static constexpr int TILE_COLS = 4;
+  static constexpr int TILE_SIZE = TILE_ROWS*TILE_COLS;
+  static constexpr int CACHE_LINE_BYTES = 64;
+  static_assert(TILE_SIZE*sizeof(uint16_t) == CACHE_LINE_BYTES, "a tile has to fill one cache line");
+  
+  TiledClearanceGrid();
+  ~TiledClearanceGrid();
+  
+  // data has to start at index (0, 0); meters_per_unit converts a cell value into metres
+  // clearance above 655.35 m saturates
+  void build(const grid_map::Matrix& data,
+             const grid_map::Position& map_position,
+             const double resolution,
+             const double meters_per_unit);
+  
+  // nearest cell; returns false if position is out of the map
+  bool sample(const Eigen::Vector2d& position, double& clearance) const
+  {
+    const double u = (top_left_corner_(0) - position(0))*inverse_resolution_;
+    const double v = (top_left_corner_(1) - position(1))*inverse_resolution_;
+    if(!(u >= 0 && u < rows_ && v >= 0 && v < cols_))
+    {
+      return false;
+    }
+    clearance = centimeters_[calculateOffset(static_cast<int>(u), static_cast<int>(v))]*0.01;
+    return true;
+  }
+  
+  // one column per position; out of map positions get invalid_clearance
+  // returns the number of positions in the map
+  size_t sample(const Eigen::Matrix2Xd& positions,
+                Eigen::VectorXd& clearances,
+                const double invalid_clearance) const;
+  
+  size_t getMemoryBytes() const;
+  
+private:
+  int rows_;
+  int cols_;
+  int number_of_tile_rows_;
+  Eigen::Vector2d top_left_corner_;
+  double inverse_resolution_;
+  // padded by one cache line; tiles start at aligned_offset_, the first element on a 64 byte boundary
+  std::vector<uint16_t> centimeters_;
+  int aligned_offset_;
+  
+  int calculateOffset(const int row, const int col) const
+  {
+    const int tile_index = row/TILE_ROWS + (col/TILE_COLS)*number_of_tile_rows_;
+    return aligned_offset_ + tile_index*TILE_SIZE + row%TILE_ROWS + (col%TILE_COLS)*TILE_ROWS;
+  }
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// fixed number of threads consuming a FIFO task queue
+class WorkerPool
+{
+public:
+  // 0 means std::thread::hardware_concurrency()
+  explicit WorkerPool(const size_t num_threads);
+  ~WorkerPool();
+
+  template <typename Task>
+  std::future<typename std::result_of<Task()>::type> submit(Task task)
+  {
+    typedef typename std::result_of<Task()>::type Result;
+    std::shared_ptr<std::packaged_task<Result()>> packaged_task =
+      std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packaged_task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push([packaged_task](){ (*packaged_task)(); });
+    }
+    condition_.notify_one();
+    return result;
+  }
+
+  size_t size() const;
+
+private:
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool is_stopped_;
+
+  void work();
+};
+
+#endif
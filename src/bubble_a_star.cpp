@@ -0,0 +1,292 @@
+#include <cmath>
+#include <queue>
+#include <chrono>
+#include <algorithm>
+
+#include "bubble_a_star.h"
+
+namespace
+{
+// unit vectors every 5 degrees; a node is expanded along every stride-th of them
+constexpr int NUM_DIRECTION_TABLE = 72;
+constexpr double DIRECTION_TABLE[NUM_DIRECTION_TABLE][2] = {
+  {1, 0},
+  {0.99619469809174555, 0.087155742747658166},
+  {0.98480775301220802, 0.17364817766693033},
+  {0.96592582628906831, 0.25881904510252074},
+  {0.93969262078590843, 0.34202014332566871},
+  {0.90630778703664994, 0.42261826174069944},
+  {0.86602540378443871, 0.49999999999999994},
+  {0.8191520442889918, 0.57357643635104605},
+  {0.76604444311897801, 0.64278760968653925},
+  {0.70710678118654757, 0.70710678118654746},
+  {0.64278760968653936, 0.76604444311897801},
+  {0.57357643635104616, 0.81915204428899169},
+  {0.50000000000000011, 0.8660254037844386},
+  {0.42261826174069944, 0.90630778703664994},
+  {0.34202014332566882, 0.93969262078590832},
+  {0.25881904510252096, 0.9659258262890682},
+  {0.17364817766693041, 0.98480775301220802},
+  {0.087155742747658138, 0.99619469809174555},
+  {0, 1},
+  {-0.087155742747658013, 0.99619469809174555},
+  {-0.1736481776669303, 0.98480775301220802},
+  {-0.25881904510252085, 0.96592582628906831},
+  {-0.34202014332566849, 0.93969262078590843},
+  {-0.42261826174069933, 0.90630778703665005},
+  {-0.49999999999999978, 0.86602540378443871},
+  {-0.57357643635104616, 0.81915204428899169},
+  {-0.64278760968653936, 0.76604444311897801},
+  {-0.70710678118654746, 0.70710678118654757},
+  {-0.7660444431189779, 0.64278760968653947},
+  {-0.81915204428899191, 0.57357643635104594},
+  {-0.86602540378443849, 0.50000000000000033},
+  {-0.90630778703664994, 0.4226182617406995},
+  {-0.93969262078590832, 0.34202014332566888},
+  {-0.96592582628906831, 0.25881904510252057},
+  {-0.98480775301220802, 0.17364817766693028},
+  {-0.99619469809174555, 0.087155742747658194},
+  {-1, 0},
+  {-0.99619469809174555, -0.087155742747657944},
+  {-0.98480775301220813, -0.17364817766693003},
+  {-0.96592582628906842, -0.25881904510252035},
+  {-0.93969262078590843, -0.34202014332566866},
+  {-0.90630778703665027, -0.42261826174069889},
+  {-0.8660254037844386, -0.50000000000000011},
+  {-0.81915204428899202, -0.57357643635104583},
+  {-0.76604444311897835, -0.64278760968653892},
+  {-0.70710678118654768, -0.70710678118654746},
+  {-0.64278760968653947, -0.7660444431189779},
+  {-0.57357643635104572, -0.81915204428899213},
+  {-0.50000000000000044, -0.86602540378443837},
+  {-0.42261826174069994, -0.90630778703664971},
+  {-0.34202014332566855, -0.93969262078590843},
+  {-0.25881904510252063, -0.96592582628906831},
+  {-0.17364817766693033, -0.98480775301220802},
+  {-0.087155742747658249, -0.99619469809174555},
+  {0, -1},
+  {0.087155742747657888, -0.99619469809174555},
+  {0.17364817766692997, -0.98480775301220813},
+  {0.2588190451025203, -0.96592582628906842},
+  {0.34202014332566899, -0.93969262078590832},
+  {0.42261826174069883, -0.90630778703665027},
+  {0.49999999999999933, -0.86602540378443904},
+  {0.57357643635104605, -0.8191520442889918},
+  {0.64278760968653925, -0.76604444311897812},
+  {0.70710678118654735, -0.70710678118654768},
+  {0.76604444311897779, -0.64278760968653958},
+  {0.81915204428899158, -0.57357643635104649},
+  {0.86602540378443882, -0.49999999999999967},
+  {0.90630778703664971, -0.4226182617407},
+  {0.93969262078590843, -0.3420201433256686},
+  {0.96592582628906831, -0.25881904510252068},
+  {0.98480775301220802, -0.17364817766693039},
+  {0.99619469809174555, -0.087155742747658319}
+};
+// 36 directions, the fixed branching
+constexpr int DEFAULT_DIRECTION_STRIDE = 2;
+}
+
+BubbleAStar::BubbleAStar(const double min_r, const double max_r, const bool use_adaptive_branching):
+min_r_(min_r),
+max_r_(max_r),
+use_adaptive_branching_(use_adaptive_branching),
+last_node_index_(-1)
+{
+  statistics_ = BubbleAStarStatistics();
+}
+
+BubbleAStar::~BubbleAStar()
+{
+}
+
+bool BubbleAStar::search(const Eigen::Vector2d& start_p,
+                         const double start_r,
+                         const Eigen::Vector2d& goal_p,
+                         const double goal_r,
+                         const ClearanceFunction& clearance_function,
+                         const HeuristicFunction& heuristic_function)
+{
+  std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
+  nodes_.clear();
+  closed_node_indices_.clear();
+  closed_node_hash_.clear();
+  last_node_index_ = -1;
+  statistics_ = BubbleAStarStatistics();
+  
+  BubbleNode goal_node;
+  goal_node.p = goal_p;
+  goal_node.r = goal_r;
+  goal_node.g = 0;
+  goal_node.h = 0;
+  goal_node.f = 0;
+  goal_node.parent_index = -1;
+  
+  BubbleNode initial_node;
+  initial_node.p = start_p;
+  initial_node.r = start_r;
+  initial_node.g = 0;
+  initial_node.h = heuristic_function ? heuristic_function(start_p) : (goal_p - start_p).norm();
+  initial_node.f = initial_node.g + initial_node.h;
+  initial_node.parent_index = -1;
+  nodes_.push_back(initial_node);
+  
+  // ties are broken by pool index so that the search is deterministic
+  std::priority_queue<OpenElement, std::vector<OpenElement>, std::greater<OpenElement>> open_queue;
+  open_queue.push(OpenElement(initial_node.f, 0));
+  
+  int goal_node_index = -1;
+  while(!open_queue.empty())
+  {
+    const OpenElement lowest_f_element = open_queue.top();
+    open_queue.pop();
+    const int node_index = lowest_f_element.second;
+    if(isInsideClosedNode(nodes_[node_index].p))
+    {
+      statistics_.number_of_skipped_nodes++;
+      continue;
+    }
+    // the first popped node reaching the goal has the lowest f of all; its children are never needed
+    if(isOverlap(nodes_[node_index], goal_node))
+    {
+      addClosedNode(node_index);
+      goal_node_index = node_index;
+      break;
+    }
+    statistics_.number_of_expansions++;
+    
+    // copy; nodes_ may reallocate while children are pushed
+    const BubbleNode parent_node = nodes_[node_index];
+    const double current_r = std::min(std::max(parent_node.r, min_r_), max_r_);
+    const bool has_grand_parent = parent_node.parent_index >= 0;
+    const Eigen::Vector2d grand_parent_p = has_grand_parent ? nodes_[parent_node.parent_index].p : parent_node.p;
+    const double grand_parent_r = has_grand_parent ? nodes_[parent_node.parent_index].r : 0;
+    const int stride = selectDirectionStride(current_r);
+    for(int direction_index = 0; direction_index < NUM_DIRECTION_TABLE; direction_index += stride)
+    {
+      BubbleNode child_node;
+      child_node.p(0) = parent_node.p(0) + current_r*DIRECTION_TABLE[direction_index][0];
+      child_node.p(1) = parent_node.p(1) + current_r*DIRECTION_TABLE[direction_index][1];
+      // heading back into the closed grand parent; it would be skipped when popped anyway
+      if(has_grand_parent && (child_node.p - grand_parent_p).squaredNorm() < grand_parent_r*grand_parent_r)
+      {
+        statistics_.number_of_pruned_children++;
+        continue;
+      }
+      double clearance;
+      if(!clearance_function(child_node.p, clearance))
+      {
+        continue;
+      }
+      child_node.r = std::min(clearance, max_r_);
+      if(child_node.r < min_r_)
+      {
+        continue;
+      }
+      child_node.g = parent_node.g + current_r;
+      child_node.h = heuristic_function ? heuristic_function(child_node.p) : (goal_p - child_node.p).norm();
+      child_node.f = child_node.g + child_node.h;
+      child_node.parent_index = node_index;
+      nodes_.push_back(child_node);
+      open_queue.push(OpenElement(child_node.f, nodes_.size() - 1));
+      statistics_.number_of_generated_nodes++;
+    }
+    addClosedNode(node_index);
+  }
+  
+  last_node_index_ = goal_node_index >= 0 ? goal_node_index : closed_node_indices_.back();
+  std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+  statistics_.elapsed_second = std::chrono::duration<double>(end - begin).count();
+  return goal_node_index >= 0;
+}
+
+const std::vector<BubbleNode>& BubbleAStar::getNodes() const
+{
+  return nodes_;
+}
+
+const std::vector<int>& BubbleAStar::getClosedNodeIndices() const
+{
+  return closed_node_indices_;
+}
+
+int BubbleAStar::getLastNodeIndex() const
+{
+  return last_node_index_;
+}
+
+const BubbleAStarStatistics& BubbleAStar::getStatistics() const
+{
+  return statistics_;
+}
+
+int BubbleAStar::selectDirectionStride(const double r) const
+{
+  if(!use_adaptive_branching_)
+  {
+    return DEFAULT_DIRECTION_STRIDE;
+  }
+  // open space: 12 directions; tight gaps: 72 directions
+  if(r >= 0.75*max_r_)
+  {
+    return 6;
+  }
+  else if(r >= 0.5*max_r_)
+  {
+    return 3;
+  }
+  else if(r >= 2*min_r_)
+  {
+    return 2;
+  }
+  return 1;
+}
+
+int64_t BubbleAStar::calculateHashKey(const int cell_x, const int cell_y) const
+{
+  return (static_cast<int64_t>(cell_x) << 32) ^ static_cast<uint32_t>(cell_y);
+}
+
+void BubbleAStar::addClosedNode(const int node_index)
+{
+  closed_node_indices_.push_back(node_index);
+  const Eigen::Vector2d& p = nodes_[node_index].p;
+  const int cell_x = std::floor(p(0)/max_r_);
+  const int cell_y = std::floor(p(1)/max_r_);
+  closed_node_hash_[calculateHashKey(cell_x, cell_y)].push_back(node_index);
+}
+
+bool BubbleAStar::isInsideClosedNode(const Eigen::Vector2d& position) const
+{
+  // closed radii are at most max_r, so only the neighboring cells can contain the position
+  const int cell_x = std::floor(position(0)/max_r_);
+  const int cell_y = std::floor(position(1)/max_r_);
+  for(int d_x = -1; d_x <= 1; d_x++)
+  {
+    for(int d_y = -1; d_y <= 1; d_y++)
+    {
+      const auto cell = closed_node_hash_.find(calculateHashKey(cell_x + d_x, cell_y + d_y));
+      if(cell == closed_node_hash_.end())
+      {
+        continue;
+      }
+      for(const int closed_node_index: cell->second)
+      {
+        const BubbleNode& closed_node = nodes_[closed_node_index];
+        if((position - closed_node.p).squaredNorm() < closed_node.r*closed_node.r)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool BubbleAStar::isOverlap(const BubbleNode& node1, const BubbleNode& node2)
+{
+  const double distance = (node1.p - node2.p).norm();
+  const double max_r = std::max(node1.r, node2.r);
+  const double min_r = std::min(node1.r, node2.r);
+  return (distance - max_r) < 0.5*min_r;
+}
@@ -114,8 +114,9 @@ std::vector<Point> CalculateCenterLine::calculateCenterLineFromGlobalWaypoints(
       double p_y = previous_point.ty;
       double c_x = global_waypoints[i].pose.pose.position.x;
       double c_y = global_waypoints[i].pose.pose.position.y;
-      yaw = std::atan2(c_y - p_y, c_x - p_x);
       double delta_distance = std::sqrt(std::pow(p_x - c_x, 2) + std::pow(p_y - c_y, 2));
+      // tangent at the current point = chord yaw + half of the turn along the arc
+      yaw = std::atan2(c_y - p_y, c_x - p_x) + center_line_point.curvature*delta_distance/2;
       cumulted_s = delta_distance + previous_point.cumulated_s;
       curvature_dot = center_line_point.curvature/delta_distance;
     }
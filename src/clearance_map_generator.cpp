@@ -0,0 +1,169 @@
+#include <limits>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <distance_transform/distance_transform.hpp>
+
+#include "clearance_map_generator.h"
+#include "dynamic_clearance_map.h"
+
+ClearanceMapGenerator::ClearanceMapGenerator(const size_t num_threads):
+num_threads_(num_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : num_threads),
+dynamic_clearance_map_ptr_(new DynamicClearanceMap()),
+previous_map_position_(grid_map::Position::Zero()),
+previous_resolution_(0),
+number_of_changed_cells_(0)
+{
+}
+
+ClearanceMapGenerator::~ClearanceMapGenerator()
+{
+}
+
+bool ClearanceMapGenerator::generateClearanceMap(grid_map::Matrix& costmap_data) const
+{
+  return transformDistance(costmap_data);
+}
+
+bool ClearanceMapGenerator::generateClearanceMap(grid_map::Matrix& costmap_data,
+                                                 const std::vector<grid_map::Index>& corridor_indices,
+                                                 const double corridor_half_width_cells,
+                                                 const int margin_cells,
+                                                 const float saturated_value) const
+{
+  const grid_map::Index map_size(costmap_data.rows(), costmap_data.cols());
+  const int half_width = std::ceil(corridor_half_width_cells);
+  grid_map::Index corridor_min = map_size;
+  grid_map::Index corridor_max(-1, -1);
+  for(const auto& index: corridor_indices)
+  {
+    corridor_min = corridor_min.min(index);
+    corridor_max = corridor_max.max(index);
+  }
+  const grid_map::Index roi_start = (corridor_min - half_width).max(0).min(map_size);
+  const grid_map::Index roi_end = (corridor_max + half_width + 1).max(roi_start).min(map_size);
+  const grid_map::Size roi_size = roi_end - roi_start;
+  if(corridor_indices.empty() || roi_size.prod() == 0)
+  {
+    costmap_data.setConstant(saturated_value);
+    return false;
+  }
+  
+  // rasterize every segment only within its own bounding box
+  std::vector<uint8_t> is_in_corridor(roi_size.prod(), 0);
+  const double squared_half_width = corridor_half_width_cells*corridor_half_width_cells;
+  for(size_t i = 0; i < corridor_indices.size(); i++)
+  {
+    const grid_map::Index& segment_begin = corridor_indices[i];
+    const grid_map::Index& segment_end = corridor_indices[std::min(i + 1, corridor_indices.size() - 1)];
+    const grid_map::Index box_start = (segment_begin.min(segment_end) - half_width).max(roi_start);
+    const grid_map::Index box_end = (segment_begin.max(segment_end) + half_width + 1).min(roi_end);
+    const Eigen::Vector2d a = segment_begin.cast<double>().matrix();
+    const Eigen::Vector2d ab = (segment_end - segment_begin).cast<double>().matrix();
+    const double squared_length = ab.squaredNorm();
+    for(int col = box_start(1); col < box_end(1); col++)
+    {
+      for(int row = box_start(0); row < box_end(0); row++)
+      {
+        const Eigen::Vector2d ap = Eigen::Vector2d(row, col) - a;
+        const double t = squared_length > 0 ? std::min(1.0, std::max(0.0, ap.dot(ab)/squared_length)) : 0.0;
+        if((ap - t*ab).squaredNorm() <= squared_half_width)
+        {
+          is_in_corridor[(row - roi_start(0)) + (col - roi_start(1))*roi_size(0)] = 1;
+        }
+      }
+    }
+  }
+  
+  const grid_map::Index window_start = (roi_start - margin_cells).max(0);
+  const grid_map::Index window_end = (roi_end + margin_cells).min(map_size);
+  const grid_map::Size window_size = window_end - window_start;
+  grid_map::Matrix window = costmap_data.block(window_start(0), window_start(1), window_size(0), window_size(1));
+  const bool has_obstacle = transformDistance(window);
+  
+  const grid_map::Index roi_offset = roi_start - window_start;
+  costmap_data.setConstant(saturated_value);
+  for(int col = 0; col < roi_size(1); col++)
+  {
+    for(int row = 0; row < roi_size(0); row++)
+    {
+      if(is_in_corridor[row + col*roi_size(0)])
+      {
+        costmap_data(roi_start(0) + row, roi_start(1) + col) = window(roi_offset(0) + row, roi_offset(1) + col);
+      }
+    }
+  }
+  return has_obstacle;
+}
+
+bool ClearanceMapGenerator::transformDistance(grid_map::Matrix& data) const
+{
+  float* cells = data.data();
+  const size_t number_of_cells = data.size();
+  bool is_empty_cost = true;
+  for(size_t i = 0; i < number_of_cells; i++)
+  {
+    if(cells[i] > 0.01f)
+    {
+      cells[i] = 0.0f;
+      is_empty_cost = false;
+    }
+    else
+    {
+      cells[i] = std::numeric_limits<float>::max();
+    }
+  }
+  if(is_empty_cost)
+  {
+    data.setConstant(1);
+    return false;
+  }
+  
+  // grid_map::Matrix is column-major, i.e. a row index is the contiguous one;
+  // dope expects the last dimension contiguous, hence {cols, rows}
+  dope::Index2 size({ static_cast<dope::SizeType>(data.cols()),
+                      static_cast<dope::SizeType>(data.rows()) });
+  dope::DopeVector<float, 2> grid(cells, 0, size);
+  dt::DistanceTransform::distanceTransformL2(grid, grid, false, num_threads_);
+  return true;
+}
+
+bool ClearanceMapGenerator::updateClearanceMap(grid_map::Matrix& costmap_data,
+                                               const grid_map::Position& map_position,
+                                               const double resolution)
+{
+  // grid_map index increases as position decreases, so contents move by +delta/resolution cells
+  const grid_map::Position cell_shift = (map_position - previous_map_position_)/resolution;
+  const int shift_rows = std::round(cell_shift.x());
+  const int shift_cols = std::round(cell_shift.y());
+  const bool is_aligned = std::abs(cell_shift.x() - shift_rows) < 1e-3 &&
+                          std::abs(cell_shift.y() - shift_cols) < 1e-3;
+  const bool is_same_geometry = dynamic_clearance_map_ptr_->isInitialized() &&
+                                dynamic_clearance_map_ptr_->getRows() == static_cast<size_t>(costmap_data.rows()) &&
+                                dynamic_clearance_map_ptr_->getCols() == static_cast<size_t>(costmap_data.cols()) &&
+                                resolution == previous_resolution_;
+  previous_map_position_ = map_position;
+  previous_resolution_ = resolution;
+  
+  if(is_same_geometry && is_aligned &&
+     std::abs(shift_rows) < costmap_data.rows() && std::abs(shift_cols) < costmap_data.cols())
+  {
+    dynamic_clearance_map_ptr_->shift(shift_rows, shift_cols);
+    number_of_changed_cells_ = dynamic_clearance_map_ptr_->setCostmap(costmap_data);
+    dynamic_clearance_map_ptr_->update();
+  }
+  else
+  {
+    dynamic_clearance_map_ptr_->initialize(costmap_data);
+    number_of_changed_cells_ = costmap_data.size();
+  }
+  dynamic_clearance_map_ptr_->getClearanceMap(costmap_data);
+  return dynamic_clearance_map_ptr_->hasObstacle();
+}
+
+size_t ClearanceMapGenerator::getNumberOfChangedCells() const
+{
+  return number_of_changed_cells_;
+}
@@ -0,0 +1,263 @@
+#include <cmath>
+#include <limits>
+
+#include "dynamic_clearance_map.h"
+
+namespace
+{
+const int NO_OBSTACLE = -1;
+const float INFINITE_DISTANCE = std::numeric_limits<float>::max();
+}
+
+DynamicClearanceMap::DynamicClearanceMap():
+rows_(0),
+cols_(0),
+number_of_obstacles_(0)
+{
+}
+
+DynamicClearanceMap::~DynamicClearanceMap()
+{
+}
+
+bool DynamicClearanceMap::isInitialized() const
+{
+  return rows_ > 0 && cols_ > 0;
+}
+
+size_t DynamicClearanceMap::getRows() const
+{
+  return rows_;
+}
+
+size_t DynamicClearanceMap::getCols() const
+{
+  return cols_;
+}
+
+bool DynamicClearanceMap::hasObstacle() const
+{
+  return number_of_obstacles_ > 0;
+}
+
+void DynamicClearanceMap::initialize(const grid_map::Matrix& costmap_data)
+{
+  rows_ = costmap_data.rows();
+  cols_ = costmap_data.cols();
+  const size_t number_of_cells = costmap_data.size();
+  number_of_obstacles_ = 0;
+  distance_.assign(number_of_cells, INFINITE_DISTANCE);
+  nearest_obstacle_.assign(number_of_cells, NO_OBSTACLE);
+  is_occupied_.assign(number_of_cells, 0);
+  to_raise_.assign(number_of_cells, 0);
+  open_queue_ = decltype(open_queue_)();
+  setCostmap(costmap_data);
+  update();
+}
+
+void DynamicClearanceMap::shift(const int shift_rows, const int shift_cols)
+{
+  if(shift_rows == 0 && shift_cols == 0)
+  {
+    return;
+  }
+  const size_t number_of_cells = distance_.size();
+  std::vector<float> shifted_distance(number_of_cells, INFINITE_DISTANCE);
+  std::vector<int> shifted_nearest_obstacle(number_of_cells, NO_OBSTACLE);
+  std::vector<uint8_t> shifted_is_occupied(number_of_cells, 0);
+  number_of_obstacles_ = 0;
+  for(int col = 0; col < cols_; col++)
+  {
+    const int old_col = col - shift_cols;
+    if(old_col < 0 || old_col >= cols_)
+    {
+      continue;
+    }
+    for(int row = 0; row < rows_; row++)
+    {
+      const int old_row = row - shift_rows;
+      if(old_row < 0 || old_row >= rows_)
+      {
+        continue;
+      }
+      const int index = row + col*rows_;
+      const int old_index = old_row + old_col*rows_;
+      shifted_is_occupied[index] = is_occupied_[old_index];
+      number_of_obstacles_ += is_occupied_[old_index];
+      const int old_obstacle = nearest_obstacle_[old_index];
+      if(old_obstacle == NO_OBSTACLE)
+      {
+        continue;
+      }
+      const int obstacle_row = old_obstacle % rows_ + shift_rows;
+      const int obstacle_col = old_obstacle / rows_ + shift_cols;
+      if(obstacle_row >= 0 && obstacle_row < rows_ && obstacle_col >= 0 && obstacle_col < cols_)
+      {
+        shifted_distance[index] = distance_[old_index];
+        shifted_nearest_obstacle[index] = obstacle_row + obstacle_col*rows_;
+      }
+      else
+      {
+        // nearest obstacle left the map; raise from here
+        shifted_distance[index] = distance_[old_index];
+        shifted_nearest_obstacle[index] = NO_OBSTACLE;
+        to_raise_[index] = 1;
+      }
+    }
+  }
+  distance_.swap(shifted_distance);
+  nearest_obstacle_.swap(shifted_nearest_obstacle);
+  is_occupied_.swap(shifted_is_occupied);
+  
+  for(int index = 0; index < static_cast<int>(number_of_cells); index++)
+  {
+    if(to_raise_[index])
+    {
+      open_queue_.push(QueueElement(distance_[index], index));
+      distance_[index] = INFINITE_DISTANCE;
+    }
+    else if(nearest_obstacle_[index] != NO_OBSTACLE)
+    {
+      // cells next to the entering border have to propagate into it
+      const int row = index % rows_;
+      const int col = index / rows_;
+      const int old_row = row - shift_rows;
+      const int old_col = col - shift_cols;
+      if(old_row <= 0 || old_row >= rows_ - 1 || old_col <= 0 || old_col >= cols_ - 1)
+      {
+        open_queue_.push(QueueElement(distance_[index], index));
+      }
+    }
+  }
+}
+
+size_t DynamicClearanceMap::setCostmap(const grid_map::Matrix& costmap_data)
+{
+  const float* cells = costmap_data.data();
+  const int number_of_cells = costmap_data.size();
+  size_t number_of_changed_cells = 0;
+  for(int index = 0; index < number_of_cells; index++)
+  {
+    const uint8_t is_occupied = cells[index] > 0.01f;
+    if(is_occupied == is_occupied_[index])
+    {
+      continue;
+    }
+    number_of_changed_cells++;
+    if(is_occupied)
+    {
+      setObstacle(index);
+    }
+    else
+    {
+      removeObstacle(index);
+    }
+  }
+  return number_of_changed_cells;
+}
+
+void DynamicClearanceMap::update()
+{
+  while(!open_queue_.empty())
+  {
+    const QueueElement element = open_queue_.top();
+    open_queue_.pop();
+    const int index = element.second;
+    if(to_raise_[index])
+    {
+      raise(index);
+    }
+    else if(nearest_obstacle_[index] != NO_OBSTACLE &&
+            is_occupied_[nearest_obstacle_[index]] &&
+            element.first <= distance_[index])
+    {
+      lower(index);
+    }
+  }
+}
+
+void DynamicClearanceMap::getClearanceMap(grid_map::Matrix& clearance_data) const
+{
+  clearance_data.resize(rows_, cols_);
+  if(number_of_obstacles_ == 0)
+  {
+    clearance_data.setConstant(1);
+    return;
+  }
+  float* cells = clearance_data.data();
+  const size_t number_of_cells = distance_.size();
+  for(size_t index = 0; index < number_of_cells; index++)
+  {
+    cells[index] = distance_[index];
+  }
+}
+
+void DynamicClearanceMap::setObstacle(const int index)
+{
+  is_occupied_[index] = 1;
+  number_of_obstacles_++;
+  to_raise_[index] = 0;
+  nearest_obstacle_[index] = index;
+  distance_[index] = 0;
+  open_queue_.push(QueueElement(0, index));
+}
+
+void DynamicClearanceMap::removeObstacle(const int index)
+{
+  is_occupied_[index] = 0;
+  number_of_obstacles_--;
+  clearCell(index);
+  to_raise_[index] = 1;
+  open_queue_.push(QueueElement(0, index));
+}
+
+void DynamicClearanceMap::clearCell(const int index)
+{
+  distance_[index] = INFINITE_DISTANCE;
+  nearest_obstacle_[index] = NO_OBSTACLE;
+}
+
+void DynamicClearanceMap::lower(const int index)
+{
+  const int obstacle = nearest_obstacle_[index];
+  forEachNeighbor(index, [this, obstacle](const int neighbor)
+  {
+    if(to_raise_[neighbor])
+    {
+      return;
+    }
+    const float distance = calculateDistance(obstacle, neighbor);
+    if(distance < distance_[neighbor])
+    {
+      distance_[neighbor] = distance;
+      nearest_obstacle_[neighbor] = obstacle;
+      open_queue_.push(QueueElement(distance, neighbor));
+    }
+  });
+}
+
+void DynamicClearanceMap::raise(const int index)
+{
+  forEachNeighbor(index, [this](const int neighbor)
+  {
+    if(nearest_obstacle_[neighbor] == NO_OBSTACLE || to_raise_[neighbor])
+    {
+      return;
+    }
+    const float distance = distance_[neighbor];
+    if(!is_occupied_[nearest_obstacle_[neighbor]])
+    {
+      clearCell(neighbor);
+      to_raise_[neighbor] = 1;
+    }
+    open_queue_.push(QueueElement(distance, neighbor));
+  });
+  to_raise_[index] = 0;
+}
+
+float DynamicClearanceMap::calculateDistance(const int index1, const int index2) const
+{
+  const float d_row = index1 % rows_ - index2 % rows_;
+  const float d_col = index1 / rows_ - index2 / rows_;
+  return std::sqrt(d_row*d_row + d_col*d_col);
+}
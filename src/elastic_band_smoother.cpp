@@ -0,0 +1,143 @@
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include "elastic_band_smoother.h"
+
+ElasticBandSmoother::ElasticBandSmoother(const double anchor_weight,
+                                         const size_t max_iterations,
+                                         const double convergence_distance):
+anchor_weight_(anchor_weight),
+max_iterations_(max_iterations),
+convergence_distance_(convergence_distance)
+{
+  statistics_ = ElasticBandStatistics();
+}
+
+ElasticBandSmoother::~ElasticBandSmoother()
+{
+}
+
+bool ElasticBandSmoother::smooth(const std::vector<Eigen::Vector2d>& centers,
+                                 const std::vector<double>& bound_radii,
+                                 std::vector<Eigen::Vector2d>& points)
+{
+  std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
+  statistics_ = ElasticBandStatistics();
+  points = centers;
+  const size_t number_of_points = centers.size();
+  if(number_of_points < 3)
+  {
+    return false;
+  }
+  // unknowns are points 1 .. n-2
+  const size_t number_of_free_points = number_of_points - 2;
+  factorize(number_of_free_points);
+  
+  std::vector<double> b_x(number_of_free_points);
+  std::vector<double> b_y(number_of_free_points);
+  for(size_t iteration = 0; iteration < max_iterations_; iteration++)
+  {
+    statistics_.number_of_iterations++;
+    for(size_t k = 0; k < number_of_free_points; k++)
+    {
+      b_x[k] = anchor_weight_*points[k+1](0);
+      b_y[k] = anchor_weight_*points[k+1](1);
+    }
+    // second differences touching the fixed ends; coefficients from (x[i-1] - 2x[i] + x[i+1])^2
+    const Eigen::Vector2d& front = points.front();
+    const Eigen::Vector2d& back = points.back();
+    b_x[0] += 2*front(0);
+    b_y[0] += 2*front(1);
+    if(number_of_free_points > 1)
+    {
+      b_x[1] -= front(0);
+      b_y[1] -= front(1);
+      b_x[number_of_free_points - 2] -= back(0);
+      b_y[number_of_free_points - 2] -= back(1);
+    }
+    b_x[number_of_free_points - 1] += 2*back(0);
+    b_y[number_of_free_points - 1] += 2*back(1);
+    solve(b_x);
+    solve(b_y);
+    
+    double max_movement = 0;
+    for(size_t k = 0; k < number_of_free_points; k++)
+    {
+      const size_t i = k + 1;
+      Eigen::Vector2d new_point(b_x[k], b_y[k]);
+      const Eigen::Vector2d offset = new_point - centers[i];
+      const double offset_length = offset.norm();
+      const double bound_radius = std::max(bound_radii[i], 0.0);
+      if(offset_length > bound_radius)
+      {
+        new_point = centers[i] + offset*(bound_radius/offset_length);
+      }
+      max_movement = std::max(max_movement, (new_point - points[i]).norm());
+      points[i] = new_point;
+    }
+    if(max_movement < convergence_distance_)
+    {
+      statistics_.is_converged = true;
+      break;
+    }
+  }
+  std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+  statistics_.elapsed_second = std::chrono::duration<double>(end - begin).count();
+  return true;
+}
+
+const ElasticBandStatistics& ElasticBandSmoother::getStatistics() const
+{
+  return statistics_;
+}
+
+void ElasticBandSmoother::factorize(const size_t number_of_free_points)
+{
+  const int n = number_of_free_points;
+  // D2^T D2 restricted to the free points: 1, -4, 6, -4, 1 with 5 on both ends
+  std::vector<double> a0(n, 6 + anchor_weight_);
+  if(n == 1)
+  {
+    a0[0] = 4 + anchor_weight_;
+  }
+  else
+  {
+    a0[0] = 5 + anchor_weight_;
+    a0[n-1] = 5 + anchor_weight_;
+  }
+  d_.assign(n, 0);
+  l1_.assign(n, 0);
+  l2_.assign(n, 0);
+  for(int i = 0; i < n; i++)
+  {
+    const double a1 = -4;
+    const double a2 = 1;
+    if(i >= 2)
+    {
+      l2_[i] = a2/d_[i-2];
+    }
+    if(i >= 1)
+    {
+      l1_[i] = (a1 - (i >= 2 ? l2_[i]*l1_[i-1]*d_[i-2] : 0))/d_[i-1];
+    }
+    d_[i] = a0[i] - (i >= 1 ? l1_[i]*l1_[i]*d_[i-1] : 0) - (i >= 2 ? l2_[i]*l2_[i]*d_[i-2] : 0);
+  }
+}
+
+void ElasticBandSmoother::solve(std::vector<double>& b) const
+{
+  const int n = b.size();
+  for(int i = 0; i < n; i++)
+  {
+    b[i] -= (i >= 1 ? l1_[i]*b[i-1] : 0) + (i >= 2 ? l2_[i]*b[i-2] : 0);
+  }
+  for(int i = 0; i < n; i++)
+  {
+    b[i] /= d_[i];
+  }
+  for(int i = n - 1; i >= 0; i--)
+  {
+    b[i] -= (i + 1 < n ? l1_[i+1]*b[i+1] : 0) + (i + 2 < n ? l2_[i+2]*b[i+2] : 0);
+  }
+}
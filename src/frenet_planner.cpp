@@ -11,21 +11,31 @@
 
 #include "frenet_planner.h"
 #include "vectormap_struct.h"
+#include "lateral_polynomial.h"
+#include "frenet_geometry.h"
+#include "worker_pool.h"
 
 #include <numeric>
 #include <cmath>
+#include <limits>
+#include <atomic>
+#include <chrono>
 
 
+// cubic: heading offset at the origin, zero slope at the target
+// switch to 5 for quintic (additionally zero d'' at both ends)
+constexpr int LATERAL_POLYNOMIAL_DEGREE = 3;
+constexpr int NUM_TRAJECTORY_SAMPLING_POINTS = 10;
+// lane points farther than this from the ego might not give a valid goal
+constexpr double MAX_DISTANCE_TO_NEAREST_LANE_POINT = 3.0;
 
 //TODO: make namespace/file for utility method
 //TODO: better naming 
 double calculate2DDistace(const geometry_msgs::Point& point1,
                           const geometry_msgs::Point& point2)
 {
-  double dx = point1.x - point2.x;
-  double dy = point1.y - point2.y;
-  double distance = std::sqrt(std::pow(dx, 2)+std::pow(dy,2));
-  return distance;
+  return calculate2DDistance<PlannerScalar>(point1.x - point2.x,
+                                           point1.y - point2.y);
 }
 
 // ref: http://www.mech.tohoku-gakuin.ac.jp/rde/contents/course/robotics/coordtrans.html
@@ -68,7 +78,8 @@ FrenetPlanner::FrenetPlanner(
   double comfort_acceleration_cost_coef,
   double lookahead_distance_per_ms_for_reference_point,
   double converge_distance_per_ms_for_stop,
-  double linear_velocity):
+  double linear_velocity,
+  const std::shared_ptr<WorkerPool>& worker_pool_ptr):
 initial_velocity_ms_(initial_velocity_ms),
 velcity_ms_before_obstalcle_(velocity_ms_before_obstalcle),
 distance_before_obstalcle_(distance_before_obstalcle),
@@ -86,7 +97,8 @@ lookahead_distance_for_reference_point_(minimum_lookahead_distance_for_reference
 converge_distance_per_ms_for_stop_(converge_distance_per_ms_for_stop),
 radius_from_reference_point_for_valid_trajectory_(10.0),
 dt_for_sampling_points_(0.5),
-linear_velocity_(linear_velocity)
+linear_velocity_(linear_velocity),
+worker_pool_ptr_(worker_pool_ptr ? worker_pool_ptr : std::make_shared<WorkerPool>(0))
 {
 }
 
@@ -95,37 +107,219 @@ FrenetPlanner::~FrenetPlanner()
 }
 
 
-void FrenetPlanner::doPlan(const geometry_msgs::PoseStamped& in_current_pose,
+bool FrenetPlanner::plan(const PlanningInput& input, PlanningOutput& output) const
+{
+  output.is_valid = false;
+  output.trajectory.waypoints.clear();
+  output.debug_trajectories.clear();
+  output.reference_points.clear();
+  output.error_message.clear();
+  if(input.lane_points.empty() || input.reference_waypoints.empty())
+  {
+    output.error_message = "empty lane points or reference waypoints";
+    return false;
+  }
+  output.is_valid = generateEntirePath(*input.current_pose,
+                                       input.lane_points,
+                                       input.reference_waypoints,
+                                       input.objects,
+                                       output.trajectory.waypoints,
+                                       input.collects_debug_trajectories ? &output.debug_trajectories : nullptr,
+                                       output.reference_points,
+                                       output.error_message);
+  return output.is_valid;
+}
+
+BatchPlanningResult FrenetPlanner::planBatch(const std::vector<PlanningScenario>& scenarios,
+                                             const bool collects_debug_trajectories) const
+{
+  BatchPlanningResult result;
+  result.outputs.resize(scenarios.size());
+  std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
+  
+  // every worker takes the next unplanned scenario until none is left
+  std::atomic<size_t> next_scenario_index(0);
+  std::vector<std::future<void>> futures;
+  for(size_t i = 0; i < worker_pool_ptr_->size(); i++)
+  {
+    futures.push_back(worker_pool_ptr_->submit(
+      [this, &scenarios, &result, &next_scenario_index, collects_debug_trajectories]()
+      {
+        size_t index;
+        while((index = next_scenario_index++) < scenarios.size())
+        {
+          const PlanningScenario& scenario = scenarios[index];
+          PlanningInput input;
+          input.current_pose = &scenario.current_pose;
+          input.current_twist = &scenario.current_twist;
+          input.lane_points = scenario.lane_points;
+          input.reference_waypoints = scenario.reference_waypoints;
+          input.objects = scenario.has_objects ? &scenario.objects : nullptr;
+          input.collects_debug_trajectories = collects_debug_trajectories;
+          plan(input, result.outputs[index]);
+        }
+      }));
+  }
+  for(auto& future: futures)
+  {
+    future.get();
+  }
+  
+  std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+  result.elapsed_second = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+  result.scenarios_per_second = 0;
+  if(result.elapsed_second > 0)
+  {
+    result.scenarios_per_second = static_cast<double>(scenarios.size())/result.elapsed_second;
+  }
+  return result;
+}
+
+bool FrenetPlanner::doPlan(const geometry_msgs::PoseStamped& in_current_pose,
               const geometry_msgs::TwistStamped& in_current_twist,
               const std::vector<Point>& in_nearest_lane_points,
               const std::vector<autoware_msgs::Waypoint>& in_reference_waypoints,
               const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
               autoware_msgs::Lane& out_trajectory,
               std::vector<autoware_msgs::Lane>& out_debug_trajectories,
-              std::vector<geometry_msgs::Point>& out_reference_points)
+              std::vector<geometry_msgs::Point>& out_reference_points,
+              std::string& out_error_message) const
+{
+  PlanningInput input;
+  input.current_pose = &in_current_pose;
+  input.current_twist = &in_current_twist;
+  input.lane_points = in_nearest_lane_points;
+  input.reference_waypoints = in_reference_waypoints;
+  input.objects = in_objects_ptr.get();
+  input.collects_debug_trajectories = true;
+  PlanningOutput output;
+  bool is_valid = plan(input, output);
+  out_trajectory.waypoints = std::move(output.trajectory.waypoints);
+  out_debug_trajectories = std::move(output.debug_trajectories);
+  out_reference_points = std::move(output.reference_points);
+  out_error_message = std::move(output.error_message);
+  return is_valid;
+}
+
+bool FrenetPlanner::doPlan(const geometry_msgs::PoseStamped& in_current_pose,
+              const geometry_msgs::TwistStamped& in_current_twist,
+              const std::vector<std::vector<Point>>& in_reference_lines,
+              const std::vector<autoware_msgs::Waypoint>& in_reference_waypoints,
+              const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
+              autoware_msgs::Lane& out_trajectory,
+              std::vector<autoware_msgs::Lane>& out_debug_trajectories,
+              std::vector<geometry_msgs::Point>& out_reference_points,
+              size_t& out_selected_reference_line_index,
+              std::string& out_error_message) const
+{
+  struct ReferenceLineResult
+  {
+    double cost;
+    PlanningOutput output;
+  };
+  
+  // one task per reference line; candidates of different lines are only compared by calculatePathCost
+  const autoware_msgs::DetectedObjectArray* objects_ptr = in_objects_ptr.get();
+  std::vector<std::future<ReferenceLineResult>> futures;
+  for(const auto& reference_line: in_reference_lines)
+  {
+    const std::vector<Point>* reference_line_ptr = &reference_line;
+    futures.push_back(worker_pool_ptr_->submit(
+      [this, reference_line_ptr, objects_ptr, &in_current_pose, &in_current_twist, &in_reference_waypoints]()
+      {
+        PlanningInput input;
+        input.current_pose = &in_current_pose;
+        input.current_twist = &in_current_twist;
+        input.lane_points = *reference_line_ptr;
+        input.reference_waypoints = in_reference_waypoints;
+        input.objects = objects_ptr;
+        input.collects_debug_trajectories = true;
+        ReferenceLineResult result;
+        result.cost = std::numeric_limits<double>::max();
+        if(plan(input, result.output))
+        {
+          result.cost = calculatePathCost(result.output.trajectory.waypoints, in_reference_waypoints);
+        }
+        return result;
+      }));
+  }
+  
+  bool has_got_path = false;
+  double min_cost = std::numeric_limits<double>::max();
+  std::string reference_line_errors;
+  for(size_t i = 0; i < futures.size(); i++)
+  {
+    ReferenceLineResult result = futures[i].get();
+    if(!result.output.is_valid)
+    {
+      reference_line_errors += "; reference line " + std::to_string(i) + ": " + result.output.error_message;
+    }
+    out_debug_trajectories.insert(out_debug_trajectories.end(),
+                                  result.output.debug_trajectories.begin(),
+                                  result.output.debug_trajectories.end());
+    if(result.output.is_valid && result.cost < min_cost)
+    {
+      min_cost = result.cost;
+      has_got_path = true;
+      out_selected_reference_line_index = i;
+      out_trajectory.waypoints = std::move(result.output.trajectory.waypoints);
+      out_reference_points = std::move(result.output.reference_points);
+    }
+  }
+  if(!has_got_path)
+  {
+    out_error_message = "no valid path for any reference line" + reference_line_errors;
+  }
+  return has_got_path;
+}
+
+// running distance to the reference waypoints plus distance of the last point, both in meter,
+// so that paths generated on different reference lines are comparable
+double FrenetPlanner::calculatePathCost(
+  const std::vector<autoware_msgs::Waypoint>& path,
+  const ArrayView<autoware_msgs::Waypoint>& reference_waypoints) const
 {
-  std::vector<autoware_msgs::Waypoint> entire_path;
-  generateEntirePath(in_current_pose,
-                     in_nearest_lane_points,
-                     in_reference_waypoints,
-                     in_objects_ptr,
-                     entire_path,
-                     out_debug_trajectories,
-                     out_reference_points);
-  out_trajectory.waypoints = entire_path;
-  // previous_best_path_.reset(new std::vector<autoware_msgs::Waypoint>(entire_path));
- 
+  if(path.empty() || reference_waypoints.empty())
+  {
+    return std::numeric_limits<double>::max();
+  }
+  // path points advance along the reference, so the nearest reference waypoint is tracked
+  // with a moving index after a full search for the first point
+  size_t nearest_index = 0;
+  getNearestWaypointIndex(path.front().pose.pose.position, reference_waypoints, nearest_index);
+  double sum_distance = 0;
+  double last_distance = 0;
+  for(const auto& waypoint: path)
+  {
+    last_distance = calculate2DDistace(waypoint.pose.pose.position,
+                                       reference_waypoints[nearest_index].pose.pose.position);
+    while(nearest_index + 1 < reference_waypoints.size())
+    {
+      double next_distance = calculate2DDistace(waypoint.pose.pose.position,
+                                                reference_waypoints[nearest_index + 1].pose.pose.position);
+      if(next_distance > last_distance)
+      {
+        break;
+      }
+      last_distance = next_distance;
+      nearest_index++;
+    }
+    sum_distance += last_distance;
+  }
+  double mean_distance = sum_distance/static_cast<double>(path.size());
+  return mean_distance*diff_waypoints_cost_coef_ + last_distance*diff_last_waypoint_cost_coef_;
 }
 
 //TODO: better naming
 bool FrenetPlanner::generateEntirePath(
   const geometry_msgs::PoseStamped& current_pose,
-  const std::vector<Point>& lane_points,
-  const std::vector<autoware_msgs::Waypoint>& reference_waypoints,
-  const std::unique_ptr<autoware_msgs::DetectedObjectArray>& in_objects_ptr,
+  const ArrayView<Point>& lane_points,
+  const ArrayView<autoware_msgs::Waypoint>& reference_waypoints,
+  const autoware_msgs::DetectedObjectArray* objects_ptr,
   std::vector<autoware_msgs::Waypoint>& entire_path,
-  std::vector<autoware_msgs::Lane>& out_debug_trajectories,
-  std::vector<geometry_msgs::Point>& out_reference_points)
+  std::vector<autoware_msgs::Lane>* out_debug_trajectories,
+  std::vector<geometry_msgs::Point>& out_reference_points,
+  std::string& error_message) const
 {
   
   double frenet_s_position, frenet_d_position;
@@ -138,6 +332,13 @@ bool FrenetPlanner::generateEntirePath(
   getNearestPoint(current_pose.pose.position,
                     lane_points,
                     nearest_point);
+  if(calculate2DDistance<PlannerScalar>(current_pose.pose.position.x - nearest_point.tx,
+                                        current_pose.pose.position.y - nearest_point.ty) >
+     MAX_DISTANCE_TO_NEAREST_LANE_POINT)
+  {
+    // not fatal; overwritten if planning fails afterwards
+    error_message = "target is too far from the lane points; might not be valid goal";
+  }
   origin_point.d_state(0) = 0;
   origin_point.s_state(0) = nearest_point.cumulated_s;
   double delta_s = 5;
@@ -159,39 +360,37 @@ bool FrenetPlanner::generateEntirePath(
    for(size_t i = 0; i < number_of_path_layer; i++)
   {
   
-    std::cerr << "origin point s " << origin_point.s_state(0) << std::endl;
-    std::cerr << "reference point s " << reference_point.frenet_point.s_state(0) << std::endl;
     std::vector<Trajectory> trajectories;
-    drawTrajectories(origin_pose,
-                      origin_point,
-                      reference_point,
-                      lane_points,
-                      reference_waypoints,
-                      trajectories,
-                      out_debug_trajectories);
+    if(!drawTrajectories(origin_pose,
+                         origin_point,
+                         reference_point,
+                         lane_points,
+                         reference_waypoints,
+                         trajectories,
+                         out_debug_trajectories))
+    {
+      error_message = "no trajectory generated in drawTrajectories; please adjust jerk threshold";
+      return false;
+    }
                       
     std::unique_ptr<ReferencePoint> kept_reference_point;
     kept_reference_point.reset(new ReferencePoint(reference_point));  
     std::unique_ptr<Trajectory> kept_best_trajectory;
-    selectBestTrajectory(trajectories,
-                        in_objects_ptr,
-                        reference_waypoints,
-                        kept_reference_point,
-                        kept_best_trajectory);
-                        
-    origin_pose = kept_best_trajectory->trajectory_points.waypoints.back().pose.pose;
-    for (const auto& point:kept_best_trajectory->frenet_trajectory_points)
+    if(!selectBestTrajectory(trajectories,
+                             objects_ptr,
+                             reference_waypoints,
+                             kept_reference_point,
+                             kept_best_trajectory))
     {
-      std::cerr << "frenet s " << point.s_state(0) << std::endl;
+      error_message = "there is no collision free trajectory";
+      return false;
     }
-    
+                        
+    origin_pose = kept_best_trajectory->trajectory_points.waypoints.back().pose.pose;
     origin_point = kept_best_trajectory->frenet_trajectory_points.back();
-    std::cerr<< kept_best_trajectory->frenet_trajectory_points.size()<<std::endl;
     FrenetPoint target_point;
     target_point.d_state(0) = origin_point.d_state(0);
     target_point.s_state(0) = (origin_point.s_state(0) + delta_s);
-    std::cerr << "origin s " << origin_point.s_state(0) << std::endl;
-    std::cerr << "target s " << target_point.s_state(0) << std::endl;
     reference_point.frenet_point = target_point;
   
     // entire_path = kept_best_trajectory->trajectory_points.waypoints;
@@ -296,6 +495,7 @@ bool FrenetPlanner::generateEntirePath(
   // //             (entire_path.end(),
   // //               kept_best_trajectory->trajectory_points.waypoints.begin(),
   //               // kept_best_trajectory->trajectory_points.waypoints.end());
+  return true;
 }
 
 //TODO: draw trajectories based on reference_point parameters
@@ -303,10 +503,10 @@ bool FrenetPlanner::drawTrajectories(
               const geometry_msgs::Pose& origin_pose,
               const FrenetPoint& frenet_current_point,
               const ReferencePoint& reference_point,
-              const std::vector<Point>& lane_points,
-              const std::vector<autoware_msgs::Waypoint>& reference_waypoints,
+              const ArrayView<Point>& lane_points,
+              const ArrayView<autoware_msgs::Waypoint>& reference_waypoints,
               std::vector<Trajectory>& trajectories,
-              std::vector<autoware_msgs::Lane>& out_debug_trajectories)
+              std::vector<autoware_msgs::Lane>* out_debug_trajectories) const
 {
   // std::cerr << "lateral offset " << reference_point.lateral_max_offset << std::endl;
   // std::cerr << "lateral samp " << reference_point.lateral_sampling_resolution << std::endl;
@@ -324,7 +524,7 @@ bool FrenetPlanner::drawTrajectories(
       frenet_target_point.d_state(0) += lateral_offset;
       frenet_target_point.s_state(0) += longitudinal_offset;
       Trajectory trajectory;
-      if(generateTrajectory(
+      if(generateTrajectory<LATERAL_POLYNOMIAL_DEGREE, NUM_TRAJECTORY_SAMPLING_POINTS>(
           origin_pose,
           lane_points,
           reference_waypoints,
@@ -336,26 +536,27 @@ bool FrenetPlanner::drawTrajectories(
       {
         trajectories.push_back(trajectory);
       }
-      out_debug_trajectories.push_back(trajectory.trajectory_points);
+      if(out_debug_trajectories)
+      {
+        out_debug_trajectories->push_back(trajectory.trajectory_points);
+      }
     }
   }
-  if(trajectories.size()==0)
-  {
-    std::cerr << "ERROR: no trajectory generated in drawTrajectories; please adjust jerk threshold"  << std::endl;
-  }
+  return trajectories.size() > 0;
 }
 
 
 //TODO: include current_pose and calcualate tan(delta_theta)
+template <int PolynomialDegree, int NumSample>
 bool FrenetPlanner::generateTrajectory(
     const geometry_msgs::Pose& ego_pose,
-    const std::vector<Point>& lane_points,
-    const std::vector<autoware_msgs::Waypoint>& reference_waypoints,
+    const ArrayView<Point>& lane_points,
+    const ArrayView<autoware_msgs::Waypoint>& reference_waypoints,
     const FrenetPoint& origin_frenet_point,
     const FrenetPoint& reference_frenet_point,
     const double time_horizon,
     const double dt_for_sampling_points,
-    Trajectory& trajectory)
+    Trajectory& trajectory) const
 {
   
   Point nearest_lane_point;
@@ -368,25 +569,23 @@ bool FrenetPlanner::generateTrajectory(
   double origin_s = origin_frenet_point.s_state(0);
   double target_s = reference_frenet_point.s_state(0);
   double delta_s = target_s - origin_s;
-  Eigen::Matrix3d a; 
-  a << std::pow(delta_s, 3), std::pow(delta_s, 2), delta_s,
-                          0,                    0,       1,
-          3*delta_s*delta_s,            2*delta_s,       1;
   double target_d = reference_frenet_point.d_state(0);
   double origin_d = origin_frenet_point.d_state(0);
-  Eigen::Vector3d b;
-  b << target_d - origin_d, std::tan(delta_yaw), 0;
-  Eigen::Vector3d x = a.inverse()*b;
+  LateralPolynomial<PolynomialDegree, PlannerScalar> lateral_polynomial(origin_d,
+                                                                        std::tan(delta_yaw),
+                                                                        target_d,
+                                                                        delta_s);
+  Eigen::Matrix<PlannerScalar, NumSample, 1> sampled_delta_s;
+  Eigen::Matrix<PlannerScalar, NumSample, 1> sampled_d;
+  lateral_polynomial.template sample<NumSample>(delta_s, sampled_delta_s, sampled_d);
   
-  const size_t num_sample = 10;
-  for(size_t i = 1; i <= num_sample; i++)
+  trajectory.frenet_trajectory_points.reserve(NumSample);
+  trajectory.trajectory_points.waypoints.reserve(NumSample);
+  trajectory.calculated_trajectory_points.reserve(NumSample);
+  for(int i = 0; i < NumSample; i++)
   {
-    double calculated_s = i*delta_s/static_cast<double>(num_sample) + origin_s;
-    double tmp_delta_s = calculated_s - origin_s;
-    double calculated_d = x(0)*std::pow(tmp_delta_s, 3) + 
-                          x(1)*std::pow(tmp_delta_s, 2) +
-                          x(2)*tmp_delta_s +
-                          origin_d;
+    double calculated_s = sampled_delta_s(i) + origin_s;
+    double calculated_d = sampled_d(i);
     FrenetPoint calculated_frenet_point;
     calculated_frenet_point.s_state(0) = calculated_s;
     calculated_frenet_point.s_state(1) = linear_velocity_;
@@ -417,9 +616,9 @@ bool FrenetPlanner::generateTrajectory(
 
 
 bool FrenetPlanner::calculateWaypoint(
-                           const std::vector<Point>& lane_points, 
+                           const ArrayView<Point>& lane_points, 
                            const FrenetPoint& frenet_point,
-                           autoware_msgs::Waypoint& waypoint)
+                           autoware_msgs::Waypoint& waypoint) const
 {
   // add conversion script for low velocity
   // std::cerr << "-------" << std::endl;
@@ -459,7 +658,17 @@ bool FrenetPlanner::calculateWaypoint(
   double d_dash = d_velocity/s_velocity;
   double d_double_dash = (1/(s_velocity*s_velocity))*(d_acceleration - s_acceleration*d_dash);
   double delta_yaw = std::atan(d_dash/(1 - nearest_lane_point_curvature * d_position));
-  double waypoint_yaw = nearest_lane_point_yaw - delta_yaw;
+  geometry_msgs::Point waypoint_position;
+  double lane_yaw_at_waypoint;
+  convertFrenetPosition2CartesianPosition(s_position,
+                                          d_position,
+                                          nearest_lane_point,
+                                          nearest_lane_point_delta_s,
+                                          nearest_lane_point_yaw,
+                                          nearest_lane_point_curvature,
+                                          waypoint_position,
+                                          lane_yaw_at_waypoint);
+  double waypoint_yaw = lane_yaw_at_waypoint - delta_yaw;
   double waypoint_curvature = (std::pow(std::cos(delta_yaw),3)/
                                std::pow((1-nearest_lane_point_curvature*d_position),2))*
                               (d_double_dash +
@@ -494,22 +703,15 @@ bool FrenetPlanner::calculateWaypoint(
                               
   // std::cerr << "nearest lane yaw " << nearest_lane_point_yaw << std::endl;
   // std::cerr << "current yaw " << current_yaw << std::endl;
-  geometry_msgs::Point waypoint_position;
-  convertFrenetPosition2CartesianPosition(s_position,
-                                          d_position,
-                                          nearest_lane_point,
-                                          nearest_lane_point_delta_s,
-                                          nearest_lane_point_yaw,
-                                          waypoint_position);
   waypoint.pose.pose.position = waypoint_position;
 
   return true;
 }
 
 bool FrenetPlanner::calculateTrajectoryPoint(
-                           const std::vector<Point>& lane_points, 
+                           const ArrayView<Point>& lane_points, 
                            const FrenetPoint& frenet_point,
-                           TrajecotoryPoint& trajectory_point)
+                           TrajecotoryPoint& trajectory_point) const
 {
   // add conversion script for low velocity
   // std::cerr << "-------" << std::endl;
@@ -553,7 +755,17 @@ bool FrenetPlanner::calculateTrajectoryPoint(
   double d_dash = d_velocity/s_velocity;
   double d_double_dash = (1/(s_velocity*s_velocity))*(d_acceleration - s_acceleration*d_dash);
   double delta_yaw = std::atan(d_dash/(1 - nearest_lane_point_curvature * d_position));
-  double waypoint_yaw = nearest_lane_point_yaw - delta_yaw;
+  geometry_msgs::Point waypoint_position;
+  double lane_yaw_at_waypoint;
+  convertFrenetPosition2CartesianPosition(s_position,
+                                          d_position,
+                                          nearest_lane_point,
+                                          nearest_lane_point_delta_s,
+                                          nearest_lane_point_yaw,
+                                          nearest_lane_point_curvature,
+                                          waypoint_position,
+                                          lane_yaw_at_waypoint);
+  double waypoint_yaw = lane_yaw_at_waypoint - delta_yaw;
   double waypoint_curvature = (std::pow(std::cos(delta_yaw),3)/
                                std::pow((1-nearest_lane_point_curvature*d_position),2))*
                               (d_double_dash +
@@ -570,15 +782,8 @@ bool FrenetPlanner::calculateTrajectoryPoint(
                         -1*(nearest_lane_point_curvature_dot*d_position+
                              nearest_lane_point_curvature*d_velocity));
   
-  geometry_msgs::Point trajectory_cartesian_point;
-  convertFrenetPosition2CartesianPosition(s_position,
-                                          d_position,
-                                          nearest_lane_point,
-                                          nearest_lane_point_delta_s,
-                                          nearest_lane_point_yaw,
-                                          trajectory_cartesian_point);
-  trajectory_point.x = trajectory_cartesian_point.x;
-  trajectory_point.x = trajectory_cartesian_point.y;
+  trajectory_point.x = waypoint_position.x;
+  trajectory_point.y = waypoint_position.y;
   trajectory_point.yaw = waypoint_yaw;
   trajectory_point.curvature = waypoint_curvature;
   trajectory_point.velocity = velocity;
@@ -594,12 +799,17 @@ bool FrenetPlanner::convertFrenetPosition2CartesianPosition(
                            const geometry_msgs::Point& nearest_lane_cartesian_point,
                            const double delta_s,
                            const double delta_yaw,
-                           geometry_msgs::Point& waypoint_position)
+                           const double curvature,
+                           geometry_msgs::Point& waypoint_position,
+                           double& lane_yaw_at_waypoint) const
 {
-  waypoint_position.x = nearest_lane_cartesian_point.x + delta_s*std::cos(delta_yaw);
-  waypoint_position.y = nearest_lane_cartesian_point.y + delta_s*std::sin(delta_yaw);
-  waypoint_position.x += frenet_d*std::cos(delta_yaw-M_PI/2);
-  waypoint_position.y += frenet_d*std::sin(delta_yaw-M_PI/2);
+  // follow the local arc instead of extrapolating straight along the nearest point's yaw
+  PlannerScalar offset_x, offset_y, arc_yaw;
+  calculateFrenetOffsetOnArc<PlannerScalar>(delta_yaw, curvature, delta_s, frenet_d,
+                                            offset_x, offset_y, arc_yaw);
+  waypoint_position.x = nearest_lane_cartesian_point.x + offset_x;
+  waypoint_position.y = nearest_lane_cartesian_point.y + offset_y;
+  lane_yaw_at_waypoint = arc_yaw;
 
   return true;
   // std::cerr <<"cumulated s "<< point.cumulated_s << std::endl;
@@ -607,16 +817,19 @@ bool FrenetPlanner::convertFrenetPosition2CartesianPosition(
 
 bool FrenetPlanner::convertCartesianPosition2FrenetPosition(
         const geometry_msgs::Point& cartesian_point,
-        const std::vector<Point> lane_points,        
+        const ArrayView<Point>& lane_points,        
         double& frenet_s_position,
-        double& frenet_d_position)
+        double& frenet_d_position) const
 {
   //TODO: redundant
   Point nearest_point, second_nearest_point;
-  getNearestPoints(cartesian_point,
-                    lane_points,
-                    nearest_point,
-                    second_nearest_point);
+  if(!getNearestPoints(cartesian_point,
+                       lane_points,
+                       nearest_point,
+                       second_nearest_point))
+  {
+    return false;
+  }
   double x1 = nearest_point.tx;
   double y1 = nearest_point.ty;
   double x2 = second_nearest_point.tx;
@@ -667,14 +880,16 @@ bool FrenetPlanner::convertCartesianPosition2FrenetPosition(
   // Eigen::Vecto
   frenet_d_position = current_d_position;
   frenet_s_position = current_s_position;
+  return true;
 }
     
     
 // TODO: redundant
-void FrenetPlanner::getNearestPoints(const geometry_msgs::Point& point,
-                                    const std::vector<Point>& nearest_lane_points,
+// false if there is no second point
+bool FrenetPlanner::getNearestPoints(const geometry_msgs::Point& point,
+                                    const ArrayView<Point>& nearest_lane_points,
                                     Point& nearest_point,
-                                    Point& second_nearest_point)
+                                    Point& second_nearest_point) const
 {
   double min_dist = 99999;
   for(const auto& sub_point: nearest_lane_points)
@@ -701,22 +916,12 @@ void FrenetPlanner::getNearestPoints(const geometry_msgs::Point& point,
       is_initialized = true;
     }
   }
-  if (!is_initialized)
-  {
-    std::cerr << "second is not initialized"  << std::endl;
-  }
-  
-  
-  double threshold = 3;
-  if(min_dist > threshold)
-  {
-    std::cerr << "error: target is too far; might not be valid goal" << std::endl;
-  }
+  return is_initialized;
 }
 
 void FrenetPlanner::getNearestPoint(const geometry_msgs::Point& compare_point,
-                                    const std::vector<Point>& lane_points,
-                                    Point& nearest_point)
+                                    const ArrayView<Point>& lane_points,
+                                    Point& nearest_point) const
 {
   double min_dist = 99999;
   for(const auto& sub_point: lane_points)
@@ -737,7 +942,7 @@ void FrenetPlanner::getNearestPoint(const geometry_msgs::Point& compare_point,
 void FrenetPlanner::getNearestWaypoints(const geometry_msgs::Pose& point,
                                     const autoware_msgs::Lane& waypoints,
                                     autoware_msgs::Waypoint& nearest_waypoint,
-                                    autoware_msgs::Waypoint& second_nearest_waypoint)
+                                    autoware_msgs::Waypoint& second_nearest_waypoint) const
 {
   double min_dist = 99999;
   size_t min_waypoint_index = 0;
@@ -769,8 +974,8 @@ void FrenetPlanner::getNearestWaypoints(const geometry_msgs::Pose& point,
 // TODO: redundant 
 // TODO: make it faster
 void FrenetPlanner::getNearestWaypoint(const geometry_msgs::Point& point,
-                                    const std::vector<autoware_msgs::Waypoint>& waypoints,
-                                    autoware_msgs::Waypoint& nearest_waypoint)
+                                    const ArrayView<autoware_msgs::Waypoint>& waypoints,
+                                    autoware_msgs::Waypoint& nearest_waypoint) const
 {
   double min_dist = 99999;
   for(size_t i = 0 ; i < waypoints.size(); i++)
@@ -788,8 +993,8 @@ void FrenetPlanner::getNearestWaypoint(const geometry_msgs::Point& point,
 
 //TODO: make method for redundant part
 void FrenetPlanner::getNearestWaypointIndex(const geometry_msgs::Point& point,
-                                    const std::vector<autoware_msgs::Waypoint>& waypoints,
-                                    size_t& nearest_waypoint_index)
+                                    const ArrayView<autoware_msgs::Waypoint>& waypoints,
+                                    size_t& nearest_waypoint_index) const
 {
   double min_dist = 99999;
   for(size_t i = 0 ; i < waypoints.size(); i++)
@@ -808,10 +1013,10 @@ void FrenetPlanner::getNearestWaypointIndex(const geometry_msgs::Point& point,
 
 bool FrenetPlanner::selectBestTrajectory(
       const std::vector<Trajectory>& trajectories,
-      const std::unique_ptr<autoware_msgs::DetectedObjectArray>& objects_ptr,
-      const std::vector<autoware_msgs::Waypoint>& reference_waypoints, 
+      const autoware_msgs::DetectedObjectArray* objects_ptr,
+      const ArrayView<autoware_msgs::Waypoint>& reference_waypoints, 
       std::unique_ptr<ReferencePoint>& kept_reference_point,
-      std::unique_ptr<Trajectory>& kept_best_trajectory)
+      std::unique_ptr<Trajectory>& kept_best_trajectory) const
 {
   
   std::vector<double> ref_waypoints_costs;
@@ -930,28 +1135,20 @@ bool FrenetPlanner::selectBestTrajectory(
   } 
   
   //TODO: this might be bad effect
-  if(!has_got_best_trajectory)
-  {
-    std::cerr << "ERROR: there is no trajectory"  << std::endl;
-    return false;
-  }
-  else
-  {
-    return true;
-  }
+  return has_got_best_trajectory;
 }
 
 bool FrenetPlanner::isCollision(const autoware_msgs::Waypoint& waypoint,
-                                const autoware_msgs::DetectedObjectArray& objects)
+                                const autoware_msgs::DetectedObjectArray& objects) const
 {
   //TODO: more sophisticated collision check
   for(const auto& object: objects.objects)
   {
-    double distance = calculate2DDistace(waypoint.pose.pose.position,
-                                          object.pose.position);
     //TODO: paremater
     //assuming obstacle is not car but corn
-    if(distance < obstacle_radius_from_center_point_)
+    if(isWithin2DRadius<PlannerScalar>(waypoint.pose.pose.position.x - object.pose.position.x,
+                                       waypoint.pose.pose.position.y - object.pose.position.y,
+                                       obstacle_radius_from_center_point_))
     {
       return true;
     }
@@ -962,16 +1159,16 @@ bool FrenetPlanner::isCollision(const autoware_msgs::Waypoint& waypoint,
 bool FrenetPlanner::isCollision(const autoware_msgs::Waypoint& waypoint,
                                 const autoware_msgs::DetectedObjectArray& objects,
                                 size_t& collision_object_id,
-                                size_t& collision_object_index)
+                                size_t& collision_object_index) const
 {
   //TODO: more sophisticated collision check
   for(size_t i = 0; i < objects.objects.size(); i++)
   {
-    double distance = calculate2DDistace(waypoint.pose.pose.position,
-                                          objects.objects[i].pose.position);
     //TODO: paremater
     //assuming obstacle is not car but corn
-    if(distance < 2.5)
+    if(isWithin2DRadius<PlannerScalar>(waypoint.pose.pose.position.x - objects.objects[i].pose.position.x,
+                                       waypoint.pose.pose.position.y - objects.objects[i].pose.position.y,
+                                       2.5))
     {
       collision_object_id = objects.objects[i].id;
       collision_object_index = i;
@@ -987,7 +1184,7 @@ bool FrenetPlanner::isTrajectoryCollisionFree(
     const autoware_msgs::DetectedObjectArray& objects,
     size_t& collision_waypoint_index,
     size_t& collision_object_id,
-    size_t& collision_object_index)
+    size_t& collision_object_index) const
 {
   for(size_t i= 0; i< trajectory_points.size(); i++)
   {
@@ -1011,7 +1208,7 @@ bool FrenetPlanner::isTrajectoryCollisionFree(
 //not sure this overload is good or bad
 bool FrenetPlanner::isTrajectoryCollisionFree(
     const std::vector<autoware_msgs::Waypoint>& trajectory_points,
-    const autoware_msgs::DetectedObjectArray& objects)
+    const autoware_msgs::DetectedObjectArray& objects) const
 {
   for(const auto& point: trajectory_points)
   {
@@ -22,6 +22,9 @@ int main(int argc, char** argv)
 {
   ros::init(argc, argv, "frenet_planner");
   FrenetPlannerROS node;
-  ros::spin();
+  // input callbacks only post to mailboxes, so they can run concurrently with planning;
+  // timerCallback skips a tick while the previous planning cycle still runs
+  ros::MultiThreadedSpinner spinner(0);
+  spinner.spin();
   return 0;
 }
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2018-2019 Autoware Foundation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <ros/ros.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "frenet_planner_ros.h"
+
+namespace frenet_planner
+{
+// runs FrenetPlannerROS inside a nodelet manager,
+// so that messages from nodelets in the same manager arrive as shared pointers without serialization
+class FrenetPlannerNodelet : public nodelet::Nodelet
+{
+private:
+  std::unique_ptr<FrenetPlannerROS> frenet_planner_ros_ptr_;
+  
+  void onInit() override
+  {
+    // input callbacks only post to mailboxes, and timerCallback never runs two planning cycles at once,
+    // so the multi-threaded queue is safe
+    frenet_planner_ros_ptr_.reset(new FrenetPlannerROS(getMTNodeHandle(), getMTPrivateNodeHandle()));
+  }
+};
+}
+
+PLUGINLIB_EXPORT_CLASS(frenet_planner::FrenetPlannerNodelet, nodelet::Nodelet)
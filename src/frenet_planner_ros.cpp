@@ -16,10 +16,18 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <pthread.h>
+#include <sched.h>
 
 
 #include <ros/ros.h>
 #include <visualization_msgs/MarkerArray.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <tf2/utils.h>
 #include <tf2_ros/transform_listener.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
@@ -38,19 +46,204 @@
 #include <grid_map_msgs/GridMap.h>
 
 #include "frenet_planner.h"
+#include "worker_pool.h"
 #include "vectormap_ros.h"
 #include "vectormap_struct.h"
 #include "calculate_center_line.h"
 #include "modified_reference_path_generator.h"
+#include "progress_tracker.h"
+#include "rigid_transform.h"
+#include "planning_trigger.h"
+#include "latency_statistics.h"
 
 #include "frenet_planner_ros.h"
 
+namespace
+{
+// points searched around the previous nearest point of a path
+const size_t PROGRESS_TRACKER_BACKWARD_WINDOW = 3;
+const size_t PROGRESS_TRACKER_FORWARD_WINDOW = 10;
+
+// planning cycles per report of the sensor to publish latency
+const size_t LATENCY_REPORT_INTERVAL = 100;
+
+// shares ownership of a received ROS message without copying it;
+// the deleter keeps the message alive as long as any copy of the returned pointer
+template <typename T>
+std::shared_ptr<const T> toStdSharedPtr(const boost::shared_ptr<const T>& msg)
+{
+  return std::shared_ptr<const T>(msg.get(), [msg](const T*){});
+}
+
+double calculateSquared2DDistance(const geometry_msgs::Point& point1, const geometry_msgs::Point& point2)
+{
+  const double dx = point1.x - point2.x;
+  const double dy = point1.y - point2.y;
+  return dx*dx + dy*dy;
+}
+
+// squared distance from point to the segment between begin and end
+double calculateSquared2DDistanceToSegment(const geometry_msgs::Point& point,
+                                           const geometry_msgs::Point& begin,
+                                           const geometry_msgs::Point& end)
+{
+  const double segment_x = end.x - begin.x;
+  const double segment_y = end.y - begin.y;
+  const double squared_length = segment_x*segment_x + segment_y*segment_y;
+  double t = 0;
+  if(squared_length > 0)
+  {
+    t = ((point.x - begin.x)*segment_x + (point.y - begin.y)*segment_y)/squared_length;
+    t = std::max(0.0, std::min(1.0, t));
+  }
+  const double dx = begin.x + t*segment_x - point.x;
+  const double dy = begin.y + t*segment_y - point.y;
+  return dx*dx + dy*dy;
+}
+
+// objects within margin of the path; the bounding box of the path rejects far objects first
+void cullObjectsOutsideCorridor(const autoware_msgs::DetectedObjectArray& objects,
+                                const ArrayView<autoware_msgs::Waypoint>& path,
+                                const double margin,
+                                autoware_msgs::DetectedObjectArray& corridor_objects)
+{
+  corridor_objects.header = objects.header;
+  corridor_objects.objects.clear();
+  if(path.empty())
+  {
+    return;
+  }
+  double min_x = std::numeric_limits<double>::max();
+  double min_y = std::numeric_limits<double>::max();
+  double max_x = std::numeric_limits<double>::lowest();
+  double max_y = std::numeric_limits<double>::lowest();
+  for(const auto& waypoint: path)
+  {
+    const geometry_msgs::Point& position = waypoint.pose.pose.position;
+    min_x = std::min(min_x, position.x);
+    min_y = std::min(min_y, position.y);
+    max_x = std::max(max_x, position.x);
+    max_y = std::max(max_y, position.y);
+  }
+  const double squared_margin = margin*margin;
+  for(const auto& object: objects.objects)
+  {
+    const geometry_msgs::Point& position = object.pose.position;
+    if(position.x < min_x - margin || position.x > max_x + margin ||
+       position.y < min_y - margin || position.y > max_y + margin)
+    {
+      continue;
+    }
+    bool is_in_corridor = calculateSquared2DDistance(position, path.front().pose.pose.position) <= squared_margin;
+    for(size_t i = 1; i < path.size() && !is_in_corridor; i++)
+    {
+      is_in_corridor = calculateSquared2DDistanceToSegment(position,
+                                                           path[i-1].pose.pose.position,
+                                                           path[i].pose.pose.position) <= squared_margin;
+    }
+    if(is_in_corridor)
+    {
+      corridor_objects.objects.push_back(object);
+    }
+  }
+}
+
+// marker at index of marker_array; reused markers keep their point capacity
+// the reference is valid until the next call since the array may grow
+visualization_msgs::Marker& reuseMarker(visualization_msgs::MarkerArray& marker_array, const size_t index)
+{
+  if(marker_array.markers.size() <= index)
+  {
+    marker_array.markers.resize(index + 1);
+  }
+  visualization_msgs::Marker& marker = marker_array.markers[index];
+  marker.points.clear();
+  return marker;
+}
+
+// convert only the last layer of msg, which is the one the reference path generator reads;
+// the message data is wrapped with Eigen::Map when it is stored column-major like grid_map::Matrix
+void convertLastLayer(const grid_map_msgs::GridMap& msg, grid_map::GridMap& grid_map)
+{
+  const std::string& layer = msg.layers.back();
+  const std_msgs::Float32MultiArray& array = msg.data.back();
+  const grid_map::Length length(msg.info.length_x, msg.info.length_y);
+  const grid_map::Size size = (length/msg.info.resolution).round().cast<int>();
+  const bool is_mappable = array.layout.dim.size() == 2 &&
+                           array.layout.dim[0].label == "column_index" &&
+                           array.layout.data_offset == 0 &&
+                           static_cast<int>(array.layout.dim[0].size) == size(1) &&
+                           static_cast<int>(array.layout.dim[1].size) == size(0);
+  if(!is_mappable)
+  {
+    grid_map = grid_map::GridMap();
+    grid_map::GridMapRosConverter::fromMessage(msg, grid_map, std::vector<std::string>{layer}, false, false);
+    return;
+  }
+  
+  if(grid_map.getLayers().size() != 1 || grid_map.getLayers().front() != layer)
+  {
+    grid_map = grid_map::GridMap(std::vector<std::string>{layer});
+  }
+  grid_map.setFrameId(msg.info.header.frame_id);
+  grid_map.setTimestamp(msg.info.header.stamp.toNSec());
+  grid_map.setGeometry(length,
+                       msg.info.resolution,
+                       grid_map::Position(msg.info.pose.position.x, msg.info.pose.position.y));
+  grid_map.setStartIndex(grid_map::Index(msg.outer_start_index, msg.inner_start_index));
+  // storage of the layer is reused when the size does not change
+  grid_map.get(layer) = Eigen::Map<const grid_map::Matrix>(array.data.data(), size(0), size(1));
+}
+}
+
+// inputs of one reference path generation; copied so that the reference path thread owns them
+struct ReferencePathRequest
+{
+  std::shared_ptr<const grid_map_msgs::GridMap> gridmap_ptr;
+  geometry_msgs::Point start_point;
+  geometry_msgs::Point goal_point;
+  // global waypoints from the ego to the goal
+  std::vector<geometry_msgs::Point> reference_points;
+  geometry_msgs::TransformStamped lidar2map_tf;
+  geometry_msgs::TransformStamped map2lidar_tf;
+};
+
+// costmap with the transforms looked up when it arrived
+struct CostmapInput
+{
+  std::shared_ptr<const grid_map_msgs::GridMap> gridmap_ptr;
+  geometry_msgs::TransformStamped lidar2map_tf;
+  geometry_msgs::TransformStamped map2lidar_tf;
+};
+
+// immutable once published
+struct ReferencePath
+{
+  std::vector<autoware_msgs::Waypoint> waypoints;
+  std::vector<Point> center_line_points;
+};
+
+// planning result for the debug markers; immutable once posted
+struct DebugOutput
+{
+  std_msgs::Header header;
+  std::vector<geometry_msgs::Point> trajectory_points;
+  std::vector<autoware_msgs::Lane> debug_trajectories;
+  std::shared_ptr<const ReferencePath> reference_path_ptr;
+};
+
 FrenetPlannerROS::FrenetPlannerROS()
-  : nh_(), 
-  private_nh_("~"),
+  : FrenetPlannerROS(ros::NodeHandle(), ros::NodeHandle("~"))
+{
+}
+
+FrenetPlannerROS::FrenetPlannerROS(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+  : nh_(nh), 
+  private_nh_(private_nh),
   use_global_waypoints_as_center_line_(true),
   has_calculated_center_line_from_global_waypoints_(false),
-  got_modified_reference_path_(false)
+  last_costmap_seq_(0),
+  is_shutdown_(false)
 {
   double timer_callback_delta_second;
   private_nh_.param<double>("timer_callback_delta_second", timer_callback_delta_second, 0.1);
@@ -71,6 +264,14 @@ FrenetPlannerROS::FrenetPlannerROS()
   double linear_velocity_kmh;
   
   double min_radius;
+  int distance_transform_num_threads;
+  bool use_incremental_clearance_map;
+  bool use_clearance_roi;
+  int goal_distance_heuristic_downsample;
+  bool use_adaptive_branching;
+  bool use_bilinear_clearance;
+  bool use_tiled_clearance_grid;
+  int elastic_band_max_iterations;
   
   private_nh_.param<double>("initial_velocity_kmh", initial_velocity_kmh, 2.1);
   private_nh_.param<double>("velcity_kmh_before_obstalcle", velcity_kmh_before_obstalcle, 1.0);
@@ -88,6 +289,27 @@ FrenetPlannerROS::FrenetPlannerROS()
   private_nh_.param<double>("linear_velocity_kmh", linear_velocity_kmh, 5.0);
   private_nh_.param<bool>("only_testing_modified_global_path", only_testing_modified_global_path_, false);
   private_nh_.param<double>("min_radius", min_radius, 1.6);
+  private_nh_.param<int>("distance_transform_num_threads", distance_transform_num_threads, 0);
+  int planning_num_threads;
+  private_nh_.param<int>("planning_num_threads", planning_num_threads, 1);
+  private_nh_.param<bool>("use_incremental_clearance_map", use_incremental_clearance_map, false);
+  private_nh_.param<bool>("use_clearance_roi", use_clearance_roi, false);
+  private_nh_.param<int>("goal_distance_heuristic_downsample", goal_distance_heuristic_downsample, 0);
+  private_nh_.param<bool>("use_adaptive_branching", use_adaptive_branching, false);
+  private_nh_.param<bool>("use_bilinear_clearance", use_bilinear_clearance, false);
+  private_nh_.param<bool>("use_tiled_clearance_grid", use_tiled_clearance_grid, false);
+  private_nh_.param<int>("elastic_band_max_iterations", elastic_band_max_iterations, 0);
+  private_nh_.param<bool>("use_receding_horizon_reference_path", use_receding_horizon_reference_path_, false);
+  double reference_path_thread_delta_second;
+  private_nh_.param<double>("reference_path_thread_delta_second", reference_path_thread_delta_second, 0.0);
+  bool use_planning_thread;
+  private_nh_.param<bool>("use_planning_thread", use_planning_thread, false);
+  bool use_event_driven_planning;
+  private_nh_.param<bool>("use_event_driven_planning", use_event_driven_planning, false);
+  double min_planning_delta_second;
+  private_nh_.param<double>("min_planning_delta_second", min_planning_delta_second, 0.05);
+  private_nh_.param<double>("object_corridor_margin", object_corridor_margin_, 0.0);
+  private_nh_.param<double>("debug_publish_delta_second", debug_publish_delta_second_, 0.0);
   const double kmh2ms = 0.2778;
   const double initial_velocity_ms = initial_velocity_kmh * kmh2ms;
   const double velocity_ms_before_obstacle = velcity_kmh_before_obstalcle * kmh2ms;
@@ -109,7 +331,8 @@ FrenetPlannerROS::FrenetPlannerROS()
         comfort_acceleration_cost_coef,
         lookahead_distance_per_ms_for_reference_point,
         converge_distance_per_ms_for_stop,
-        linear_velocity_ms));
+        linear_velocity_ms,
+        std::make_shared<WorkerPool>(std::max(planning_num_threads, 0))));
   // TODO: assume that vectormap is already published when constructing FrenetPlannerROS
   if(!use_global_waypoints_as_center_line_)
   {
@@ -122,7 +345,16 @@ FrenetPlannerROS::FrenetPlannerROS()
   }
   modified_reference_path_generator_ptr_.reset(
     new ModifiedReferencePathGenerator(
-      min_radius));
+      min_radius,
+      std::max(0, distance_transform_num_threads),
+      use_incremental_clearance_map,
+      use_clearance_roi,
+      goal_distance_heuristic_downsample,
+      use_adaptive_branching,
+      use_bilinear_clearance,
+      use_tiled_clearance_grid,
+      elastic_band_max_iterations,
+      use_receding_horizon_reference_path_));
   
   tf2_buffer_ptr_.reset(new tf2_ros::Buffer());
   tf2_listner_ptr_.reset(new tf2_ros::TransformListener(*tf2_buffer_ptr_));
@@ -131,6 +363,16 @@ FrenetPlannerROS::FrenetPlannerROS()
   optimized_waypoints_pub_ = nh_.advertise<autoware_msgs::Lane>("safety_waypoints", 1, true);
   markers_pub_ = nh_.advertise<visualization_msgs::MarkerArray>("frenet_planner_debug_markes", 1, true);
   gridmap_pointcloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>("gridmap_pointcloud", 1, true);
+  // created before the subscribers since their callbacks notify it
+  const std::string planning_mode = use_event_driven_planning ? "event" : "timer";
+  if(use_event_driven_planning)
+  {
+    planning_trigger_ptr_.reset(new PlanningTrigger(min_planning_delta_second, timer_callback_delta_second));
+  }
+  pose_latency_statistics_ptr_.reset(
+    new LatencyStatistics(planning_mode + " mode pose to publish latency", LATENCY_REPORT_INTERVAL));
+  objects_latency_statistics_ptr_.reset(
+    new LatencyStatistics(planning_mode + " mode objects to publish latency", LATENCY_REPORT_INTERVAL));
   final_waypoints_sub_ = nh_.subscribe("base_waypoints", 1, &FrenetPlannerROS::waypointsCallback, this);
   current_pose_sub_ = nh_.subscribe("/current_pose", 1, &FrenetPlannerROS::currentPoseCallback, this);
   current_velocity_sub_ = nh_.subscribe("/current_velocity", 1, &FrenetPlannerROS::currentVelocityCallback, this);
@@ -140,210 +382,460 @@ FrenetPlannerROS::FrenetPlannerROS()
   // double timer_callback_dt = 0.1;
   // double timer_callback_dt = 1.0;
   // double timer_callback_dt = 0.5;
-  timer_ = nh_.createTimer(ros::Duration(timer_callback_delta_second), &FrenetPlannerROS::timerCallback, this);
+  waypoints_tracker_ptr_.reset(new ProgressTracker(PROGRESS_TRACKER_BACKWARD_WINDOW, PROGRESS_TRACKER_FORWARD_WINDOW));
+  reference_path_tracker_ptr_.reset(new ProgressTracker(PROGRESS_TRACKER_BACKWARD_WINDOW, PROGRESS_TRACKER_FORWARD_WINDOW));
+  center_line_tracker_ptr_.reset(new ProgressTracker(PROGRESS_TRACKER_BACKWARD_WINDOW, PROGRESS_TRACKER_FORWARD_WINDOW));
+  corridor_objects_ptr_.reset(new autoware_msgs::DetectedObjectArray());
+  out_lane_ptr_.reset(new autoware_msgs::Lane());
+  out_marker_array_ptr_.reset(new visualization_msgs::MarkerArray());
+  planning_output_ptr_.reset(new PlanningOutput());
+  if(use_event_driven_planning)
+  {
+    planning_thread_ = std::thread(&FrenetPlannerROS::eventDrivenPlanningLoop, this);
+  }
+  else if(use_planning_thread)
+  {
+    planning_thread_ = std::thread(&FrenetPlannerROS::planningThreadLoop,
+                                   this,
+                                   timer_callback_delta_second);
+  }
+  else
+  {
+    timer_ = nh_.createTimer(ros::Duration(timer_callback_delta_second), &FrenetPlannerROS::timerCallback, this);
+  }
+  if(reference_path_thread_delta_second > 0)
+  {
+    reference_path_thread_ = std::thread(&FrenetPlannerROS::referencePathThreadLoop,
+                                         this,
+                                         reference_path_thread_delta_second);
+  }
+  if(debug_publish_delta_second_ > 0)
+  {
+    debug_thread_ = std::thread(&FrenetPlannerROS::debugThreadLoop,
+                                this,
+                                debug_publish_delta_second_);
+  }
 }
 
 FrenetPlannerROS::~FrenetPlannerROS()
 {
+  is_shutdown_ = true;
+  if(planning_trigger_ptr_)
+  {
+    planning_trigger_ptr_->shutdown();
+  }
+  if(planning_thread_.joinable())
+  {
+    planning_thread_.join();
+  }
+  if(reference_path_thread_.joinable())
+  {
+    reference_path_thread_.join();
+  }
+  if(debug_thread_.joinable())
+  {
+    debug_thread_.join();
+  }
+}
+
+bool FrenetPlannerROS::needsReferencePathGeneration() const
+{
+  return !std::atomic_load(&reference_path_ptr_) ||
+         use_receding_horizon_reference_path_ ||
+         only_testing_modified_global_path_;
+}
+
+bool FrenetPlannerROS::generateReferencePath(const ReferencePathRequest& request)
+{
+  // the clearance of the previous generation is still valid if no new costmap has arrived
+  const std_msgs::Header& costmap_header = request.gridmap_ptr->info.header;
+  const bool is_costmap_updated = !clearance_map_ptr_ ||
+                                  costmap_header.seq != last_costmap_seq_ ||
+                                  costmap_header.stamp != last_costmap_stamp_;
+  const bool reuse_clearance_map = !is_costmap_updated &&
+                                   modified_reference_path_generator_ptr_->canReuseClearanceMap();
+  if(!clearance_map_ptr_)
+  {
+    clearance_map_ptr_.reset(new grid_map::GridMap());
+  }
+  if(!reuse_clearance_map)
+  {
+    // the generator overwrites the layer with clearance, so it is converted again when it cannot be reused
+    convertLastLayer(*request.gridmap_ptr, *clearance_map_ptr_);
+    last_costmap_seq_ = costmap_header.seq;
+    last_costmap_stamp_ = costmap_header.stamp;
+  }
+  std::vector<autoware_msgs::Waypoint> debug_astar_path;
+  std::vector<autoware_msgs::Waypoint> debug_modified_smoothed_reference_path;
+  std::vector<autoware_msgs::Waypoint> debug_bspline_path;
+  // the clearance point cloud is only made when subscribed, and at most once per debug period
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::shared_ptr<sensor_msgs::PointCloud2> debug_clearance_map_pointcloud_ptr;
+  if(gridmap_pointcloud_pub_.getNumSubscribers() > 0 &&
+     now - last_debug_pointcloud_time_ >= std::chrono::duration<double>(debug_publish_delta_second_))
+  {
+    debug_clearance_map_pointcloud_ptr = std::make_shared<sensor_msgs::PointCloud2>();
+    last_debug_pointcloud_time_ = now;
+  }
+  
+  // generator appends to the output, so always start from a fresh path
+  std::shared_ptr<ReferencePath> reference_path_ptr = std::make_shared<ReferencePath>();
+  const bool is_generated =  
+    modified_reference_path_generator_ptr_->generateModifiedReferencePath(
+        *clearance_map_ptr_,
+        reuse_clearance_map,
+        request.start_point,
+        request.goal_point,
+        request.reference_points,
+        request.lidar2map_tf,
+        request.map2lidar_tf,
+        reference_path_ptr->waypoints,
+        debug_astar_path,
+        debug_modified_smoothed_reference_path,
+        debug_bspline_path,
+        debug_clearance_map_pointcloud_ptr.get());
+  if(debug_clearance_map_pointcloud_ptr)
+  {
+    debug_clearance_map_pointcloud_ptr->header = request.gridmap_ptr->info.header;
+    if(debug_thread_.joinable())
+    {
+      debug_pointcloud_mailbox_.post(debug_clearance_map_pointcloud_ptr);
+    }
+    else
+    {
+      gridmap_pointcloud_pub_.publish(*debug_clearance_map_pointcloud_ptr);
+    }
+  }
+  
+  if(only_testing_modified_global_path_)
+  {
+    std::cerr << "modified size " << reference_path_ptr->waypoints.size() << std::endl;
+    std::cerr << "bspline size " << debug_bspline_path.size() << std::endl;
+  }
+  // keep following the previous path if generation fails
+  if(!is_generated)
+  {
+    return false;
+  }
+  
+  reference_path_ptr->center_line_points
+    = calculate_center_line_ptr_->calculateCenterLineFromGlobalWaypoints(
+      reference_path_ptr->waypoints);
+  std::atomic_store(&reference_path_ptr_, std::shared_ptr<const ReferencePath>(reference_path_ptr));
+  return true;
+}
+
+void FrenetPlannerROS::runAtRate(const double delta_second, const std::function<void()>& cycle)
+{
+  const std::chrono::steady_clock::duration period =
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(delta_second));
+  std::chrono::steady_clock::time_point next_cycle = std::chrono::steady_clock::now();
+  while(!is_shutdown_)
+  {
+    cycle();
+    // skip missed cycles instead of running them back to back
+    next_cycle += period;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(next_cycle < now)
+    {
+      next_cycle = now;
+    }
+    std::this_thread::sleep_until(next_cycle);
+  }
 }
 
+void FrenetPlannerROS::referencePathThreadLoop(const double delta_second)
+{
+  std::shared_ptr<const ReferencePathRequest> last_request_ptr;
+  runAtRate(delta_second, [this, &last_request_ptr]()
+  {
+    std::shared_ptr<const ReferencePathRequest> request_ptr = std::atomic_load(&reference_path_request_ptr_);
+    if(request_ptr && request_ptr != last_request_ptr && needsReferencePathGeneration())
+    {
+      std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+      generateReferencePath(*request_ptr);
+      std::chrono::nanoseconds elapsed_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin);
+      ROS_DEBUG("reference path thread %.3f milli sec", elapsed_time.count()/(1000.0*1000.0));
+      last_request_ptr = request_ptr;
+    }
+  });
+}
 
-void FrenetPlannerROS::waypointsCallback(const autoware_msgs::Lane& msg)
+void FrenetPlannerROS::planningThreadLoop(const double delta_second)
 {
-  in_waypoints_ptr_.reset(new autoware_msgs::Lane(msg));
+  runAtRate(delta_second, [this]()
+  {
+    runPlanningCycle();
+  });
 }
 
-void FrenetPlannerROS::currentPoseCallback(const geometry_msgs::PoseStamped & msg)
+void FrenetPlannerROS::eventDrivenPlanningLoop()
 {
-  in_pose_ptr_.reset(new geometry_msgs::PoseStamped(msg));
+  while(planning_trigger_ptr_->wait())
+  {
+    ROS_DEBUG("planning trigger coalesced events %zu", planning_trigger_ptr_->getNumberOfCoalescedEvents());
+    runPlanningCycle();
+  }
 }
 
-void FrenetPlannerROS::currentVelocityCallback(const geometry_msgs::TwistStamped& msg)
+void FrenetPlannerROS::debugThreadLoop(const double delta_second)
 {
-  in_twist_ptr_.reset(new geometry_msgs::TwistStamped(msg));
+  // visualization only gets CPU time nobody else wants
+  sched_param scheduling_parameter;
+  scheduling_parameter.sched_priority = 0;
+  if(pthread_setschedparam(pthread_self(), SCHED_IDLE, &scheduling_parameter) != 0)
+  {
+    ROS_WARN("could not lower the priority of the debug thread");
+  }
+  std::shared_ptr<const DebugOutput> last_debug_output_ptr;
+  std::shared_ptr<const sensor_msgs::PointCloud2> last_pointcloud_ptr;
+  runAtRate(delta_second, [this, &last_debug_output_ptr, &last_pointcloud_ptr]()
+  {
+    // only the latest of the outputs posted since the last cycle is published
+    const auto debug_output_letter_ptr = debug_output_mailbox_.load();
+    if(debug_output_letter_ptr && debug_output_letter_ptr->value != last_debug_output_ptr)
+    {
+      publishDebugMarkers(*debug_output_letter_ptr->value);
+      last_debug_output_ptr = debug_output_letter_ptr->value;
+    }
+    const auto pointcloud_letter_ptr = debug_pointcloud_mailbox_.load();
+    if(pointcloud_letter_ptr && pointcloud_letter_ptr->value != last_pointcloud_ptr)
+    {
+      gridmap_pointcloud_pub_.publish(*pointcloud_letter_ptr->value);
+      last_pointcloud_ptr = pointcloud_letter_ptr->value;
+    }
+  });
+}
+
+
+void FrenetPlannerROS::waypointsCallback(const autoware_msgs::LaneConstPtr& msg)
+{
+  waypoints_mailbox_.post(toStdSharedPtr(msg));
+}
+
+void FrenetPlannerROS::currentPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg)
+{
+  pose_mailbox_.post(toStdSharedPtr(msg));
+  if(planning_trigger_ptr_)
+  {
+    planning_trigger_ptr_->notify();
+  }
 }
 
-void FrenetPlannerROS::gridmapCallback(const grid_map_msgs::GridMap& msg)
+void FrenetPlannerROS::currentVelocityCallback(const geometry_msgs::TwistStampedConstPtr& msg)
+{
+  twist_mailbox_.post(toStdSharedPtr(msg));
+}
+
+void FrenetPlannerROS::gridmapCallback(const grid_map_msgs::GridMapConstPtr& msg)
 { 
-  if(in_waypoints_ptr_)
+  const auto waypoints_letter_ptr = waypoints_mailbox_.load();
+  if(waypoints_letter_ptr)
   {
-    geometry_msgs::TransformStamped lidar2map_tf;
-    geometry_msgs::TransformStamped map2lidar_tf;
+    const std::string& map_frame_id = waypoints_letter_ptr->value->header.frame_id;
+    std::shared_ptr<CostmapInput> costmap_ptr = std::make_shared<CostmapInput>();
     try
     {
-        lidar2map_tf = tf2_buffer_ptr_->lookupTransform(
-          /*target*/  in_waypoints_ptr_->header.frame_id, 
-          /*src*/ msg.info.header.frame_id,
+        costmap_ptr->lidar2map_tf = tf2_buffer_ptr_->lookupTransform(
+          /*target*/  map_frame_id, 
+          /*src*/ msg->info.header.frame_id,
           ros::Time(0));
-        lidar2map_tf_.reset(new geometry_msgs::TransformStamped(lidar2map_tf));
-        map2lidar_tf = tf2_buffer_ptr_->lookupTransform(
-          /*target*/  msg.info.header.frame_id, 
-          /*src*/ in_waypoints_ptr_->header.frame_id,
+        costmap_ptr->map2lidar_tf = tf2_buffer_ptr_->lookupTransform(
+          /*target*/  msg->info.header.frame_id, 
+          /*src*/ map_frame_id,
           ros::Time(0));
-        map2lidar_tf_.reset(new geometry_msgs::TransformStamped(map2lidar_tf));
     }
     catch (tf2::TransformException &ex)
     {
         ROS_WARN("%s", ex.what());
         return;
     }
-    in_gridmap_ptr_.reset(new grid_map_msgs::GridMap(msg));
+    costmap_ptr->gridmap_ptr = toStdSharedPtr(msg);
+    costmap_mailbox_.post(costmap_ptr);
   }
 }
 
-void FrenetPlannerROS::objectsCallback(const autoware_msgs::DetectedObjectArray& msg)
+void FrenetPlannerROS::objectsCallback(const autoware_msgs::DetectedObjectArrayConstPtr& msg)
 {
-  if(in_waypoints_ptr_)
+  const auto waypoints_letter_ptr = waypoints_mailbox_.load();
+  if(waypoints_letter_ptr)
   {
-    if(msg.objects.size() == 0)
+    if(msg->objects.size() == 0)
     {
       std::cerr << "ssize of objects is 0" << std::endl;
       return;
     }
+    const std::string& map_frame_id = waypoints_letter_ptr->value->header.frame_id;
     geometry_msgs::TransformStamped lidar2map_tf;
     try
     {
         lidar2map_tf = tf2_buffer_ptr_->lookupTransform(
-          /*target*/  in_waypoints_ptr_->header.frame_id, 
-          /*src*/ msg.header.frame_id,
+          /*target*/  map_frame_id, 
+          /*src*/ msg->header.frame_id,
           ros::Time(0));
-        lidar2map_tf_.reset(new geometry_msgs::TransformStamped(lidar2map_tf));
     }
     catch (tf2::TransformException &ex)
     {
         ROS_WARN("%s", ex.what());
         return;
     }
-    in_objects_ptr_.reset(new autoware_msgs::DetectedObjectArray(msg));
-    in_objects_ptr_->header.frame_id = in_waypoints_ptr_->header.frame_id;
-    for(auto& object: in_objects_ptr_->objects)
+    // poses are rewritten in map frame, so this input is the one that is copied
+    std::shared_ptr<autoware_msgs::DetectedObjectArray> objects_ptr =
+      std::make_shared<autoware_msgs::DetectedObjectArray>(*msg);
+    objects_ptr->header.frame_id = map_frame_id;
+    std::vector<autoware_msgs::DetectedObject>& objects = objects_ptr->objects;
+    const RigidTransform lidar2map_transform(lidar2map_tf);
+    Eigen::Matrix3Xd positions(3, objects.size());
+    for(size_t i = 0; i < objects.size(); i++)
     {
-      object.header.frame_id = in_waypoints_ptr_->header.frame_id;
-      geometry_msgs::PoseStamped current_object_pose;
-      current_object_pose.header = object.header;
-      current_object_pose.pose = object.pose;
-      geometry_msgs::PoseStamped transformed_pose;
-      tf2::doTransform(current_object_pose, transformed_pose, *lidar2map_tf_);
-      object.pose = transformed_pose.pose;
+      const geometry_msgs::Point& position = objects[i].pose.position;
+      positions.col(i) << position.x, position.y, position.z;
+    }
+    Eigen::Matrix3Xd transformed_positions;
+    lidar2map_transform.transformPoints(positions, transformed_positions);
+    for(size_t i = 0; i < objects.size(); i++)
+    {
+      objects[i].header.frame_id = map_frame_id;
+      objects[i].pose.position.x = transformed_positions(0, i);
+      objects[i].pose.position.y = transformed_positions(1, i);
+      objects[i].pose.position.z = transformed_positions(2, i);
+      objects[i].pose.orientation = lidar2map_transform.transformOrientation(objects[i].pose.orientation);
+    }
+    objects_mailbox_.post(objects_ptr);
+    if(planning_trigger_ptr_)
+    {
+      planning_trigger_ptr_->notify();
     }
   }
 }
 
 void FrenetPlannerROS::timerCallback(const ros::TimerEvent &e)
 {
-  if(!in_pose_ptr_)
+  std::unique_lock<std::mutex> lock(timer_planning_mutex_, std::try_to_lock);
+  if(!lock.owns_lock())
+  {
+    return;
+  }
+  runPlanningCycle();
+}
+
+void FrenetPlannerROS::runPlanningCycle()
+{
+  // one consistent snapshot of the inputs for this cycle; callbacks may post newer ones meanwhile
+  const std::chrono::steady_clock::time_point snapshot_time = std::chrono::steady_clock::now();
+  const auto pose_letter_ptr = pose_mailbox_.load();
+  const auto twist_letter_ptr = twist_mailbox_.load();
+  const auto waypoints_letter_ptr = waypoints_mailbox_.load();
+  const auto costmap_letter_ptr = costmap_mailbox_.load();
+  const auto objects_letter_ptr = objects_mailbox_.load();
+  std::shared_ptr<const geometry_msgs::PoseStamped> in_pose_ptr;
+  std::shared_ptr<const geometry_msgs::TwistStamped> in_twist_ptr;
+  std::shared_ptr<const autoware_msgs::Lane> in_waypoints_ptr;
+  std::shared_ptr<const CostmapInput> in_costmap_ptr;
+  std::shared_ptr<const autoware_msgs::DetectedObjectArray> in_objects_ptr;
+  if(pose_letter_ptr)
+  {
+    in_pose_ptr = pose_letter_ptr->value;
+  }
+  if(twist_letter_ptr)
+  {
+    in_twist_ptr = twist_letter_ptr->value;
+  }
+  if(waypoints_letter_ptr)
+  {
+    in_waypoints_ptr = waypoints_letter_ptr->value;
+  }
+  if(costmap_letter_ptr)
+  {
+    in_costmap_ptr = costmap_letter_ptr->value;
+  }
+  if(objects_letter_ptr)
+  {
+    in_objects_ptr = objects_letter_ptr->value;
+  }
+  
+  if(!in_pose_ptr)
   {
     std::cerr << "pose not arrive" << std::endl;
   }
-  if(!in_twist_ptr_)
+  if(!in_twist_ptr)
   {
     std::cerr << "twist not arrive" << std::endl;
   }
-  if(!in_waypoints_ptr_)
+  if(!in_waypoints_ptr)
   {
     std::cerr << "waypoints not arrive" << std::endl;
   }
-  if(!in_gridmap_ptr_)
+  if(!in_costmap_ptr)
   {
     std::cerr << "costmap not arrive" << std::endl;
   }
   
-  if(in_pose_ptr_ && 
-     in_twist_ptr_ && 
-     in_waypoints_ptr_ && 
-     in_gridmap_ptr_) 
+  if(in_pose_ptr && 
+     in_twist_ptr && 
+     in_waypoints_ptr && 
+     in_costmap_ptr) 
   { 
+    // callback to plan latency; how long each input waited in its mailbox before this cycle took it
+    auto to_milli_sec = [&snapshot_time](const std::chrono::steady_clock::time_point& posted_time)
+    {
+      return std::chrono::duration<double, std::milli>(snapshot_time - posted_time).count();
+    };
+    // objects latency is -1 without objects
+    ROS_DEBUG_THROTTLE(1.0, "input latency pose %.3f twist %.3f waypoints %.3f costmap %.3f objects %.3f milli sec",
+                       to_milli_sec(pose_letter_ptr->posted_time),
+                       to_milli_sec(twist_letter_ptr->posted_time),
+                       to_milli_sec(waypoints_letter_ptr->posted_time),
+                       to_milli_sec(costmap_letter_ptr->posted_time),
+                       objects_letter_ptr ? to_milli_sec(objects_letter_ptr->posted_time) : -1.0);
+    
     // 1. 現在日時を取得
     std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
     
-    grid_map::GridMap grid_map;
-    grid_map::GridMapRosConverter::fromMessage(*in_gridmap_ptr_, grid_map);
-    // std::vector<autoware_msgs::Waypoint> modified_reference_path;
-    std::vector<autoware_msgs::Waypoint> debug_astar_path;
-    std::vector<autoware_msgs::Waypoint> debug_modified_smoothed_reference_path;
-    std::vector<autoware_msgs::Waypoint> debug_bspline_path;
-    sensor_msgs::PointCloud2 debug_clearance_map_pointcloud;
-    // got_modified_reference_path_ = false;
-    if(!got_modified_reference_path_)
+    // in thread mode the latest request is always handed over and the thread decides whether to generate
+    if(reference_path_thread_.joinable() || needsReferencePathGeneration())
     {
-      //TODO: make it better by using time-series data
-      //make local waypoints based on current_pose
-      std::vector<autoware_msgs::Waypoint> local_reference_waypoints;
-      double min_dist = 99999;
-      size_t closest_wp_index = 0;
-      for (size_t i = 0; i < in_waypoints_ptr_->waypoints.size(); i++)
-      {
-        double dx = in_waypoints_ptr_->waypoints[i].pose.pose.position.x - in_pose_ptr_->pose.position.x;
-        double dy = in_waypoints_ptr_->waypoints[i].pose.pose.position.y - in_pose_ptr_->pose.position.y;
-        double distance = std::sqrt(std::pow(dx, 2)+std::pow(dy,2));
-        if(distance < min_dist)
+      // goal is the first waypoint ahead of the ego beyond search_distance
+      const std::vector<autoware_msgs::Waypoint>& global_waypoints = in_waypoints_ptr->waypoints;
+      const geometry_msgs::Point& ego_position = in_pose_ptr->pose.position;
+      const size_t closest_wp_index = waypoints_tracker_ptr_->findNearestIndex(
+        in_waypoints_ptr,
+        global_waypoints.size(),
+        [&global_waypoints, &ego_position](const size_t i)
         {
-          min_dist = distance;
-          closest_wp_index = i;
-        }
-      }
-      //TODO: think better way
-      for(size_t i = closest_wp_index; i< in_waypoints_ptr_->waypoints.size(); i++)
-      {
-        local_reference_waypoints.push_back(in_waypoints_ptr_->waypoints[i]);
-      }
-      
-      
-      double min_dist_from_goal = 99999;
+          return calculateSquared2DDistance(global_waypoints[i].pose.pose.position, ego_position);
+        });
       const double search_distance = 45;
-      size_t closest_goal_wp_index = 0;
-      for (size_t i = 0; i < local_reference_waypoints.size(); i++)
+      size_t closest_goal_wp_index = closest_wp_index;
+      while(closest_goal_wp_index + 1 < global_waypoints.size() &&
+            calculateSquared2DDistance(global_waypoints[closest_goal_wp_index].pose.pose.position, ego_position) <=
+              search_distance*search_distance)
       {
-        double dx = local_reference_waypoints[i].pose.pose.position.x - in_pose_ptr_->pose.position.x;
-        double dy = local_reference_waypoints[i].pose.pose.position.y - in_pose_ptr_->pose.position.y;
-        double distance = std::sqrt(std::pow(dx, 2)+std::pow(dy,2));
-        if(distance < min_dist_from_goal && distance > search_distance)
-        {
-          min_dist_from_goal = distance;
-          closest_goal_wp_index = i;
-        }
+        closest_goal_wp_index++;
       }
-      geometry_msgs::Point goal_point = local_reference_waypoints[closest_goal_wp_index].pose.pose.position;
-      geometry_msgs::Point start_point = in_pose_ptr_->pose.position;
       
-      
-      if(only_testing_modified_global_path_)
+      std::shared_ptr<ReferencePathRequest> request_ptr = std::make_shared<ReferencePathRequest>();
+      request_ptr->gridmap_ptr = in_costmap_ptr->gridmap_ptr;
+      request_ptr->start_point = in_pose_ptr->pose.position;
+      request_ptr->goal_point = global_waypoints[closest_goal_wp_index].pose.pose.position;
+      request_ptr->reference_points.reserve(closest_goal_wp_index - closest_wp_index + 1);
+      for(size_t i = closest_wp_index; i <= closest_goal_wp_index; i++)
       {
-        modified_reference_path_.clear();
+        request_ptr->reference_points.push_back(global_waypoints[i].pose.pose.position);
       }
-      got_modified_reference_path_ =  
-        modified_reference_path_generator_ptr_->generateModifiedReferencePath(
-            grid_map,
-            start_point,
-            goal_point,
-            *lidar2map_tf_,
-            *map2lidar_tf_,
-            modified_reference_path_,
-            debug_astar_path,
-            debug_modified_smoothed_reference_path,
-            debug_bspline_path,
-            debug_clearance_map_pointcloud);
-      if(!got_modified_reference_path_)
-      { 
-        // std::vector<autoware_msgs::Waypoint> aaa;
-        // modified_reference_path_ = aaa;
-        // return;
+      request_ptr->lidar2map_tf = in_costmap_ptr->lidar2map_tf;
+      request_ptr->map2lidar_tf = in_costmap_ptr->map2lidar_tf;
+      if(reference_path_thread_.joinable())
+      {
+        std::atomic_store(&reference_path_request_ptr_,
+                          std::shared_ptr<const ReferencePathRequest>(request_ptr));
       }
-      
-      if(only_testing_modified_global_path_)
+      else
       {
-        got_modified_reference_path_ = false;
-        std::cerr << "modified size " << modified_reference_path_.size() << std::endl;
-        std::cerr << "bspline size " << debug_bspline_path.size() << std::endl;
+        generateReferencePath(*request_ptr);
       }
-      
-      // std::vector<Point> center_line_points;
-      center_line_points_
-      = calculate_center_line_ptr_->calculateCenterLineFromGlobalWaypoints(
-        modified_reference_path_);
     }
-    debug_clearance_map_pointcloud.header = in_gridmap_ptr_->info.header;
-    gridmap_pointcloud_pub_.publish(debug_clearance_map_pointcloud);
      
     // 3. 現在日時を再度取得
     std::chrono::high_resolution_clock::time_point distance_end = std::chrono::high_resolution_clock::now();
@@ -351,62 +843,64 @@ void FrenetPlannerROS::timerCallback(const ros::TimerEvent &e)
     std::chrono::nanoseconds elapsed_time = std::chrono::duration_cast<std::chrono::nanoseconds>(distance_end - begin);
     std::cout <<"distance transform " <<elapsed_time.count()/(1000.0*1000.0)<< " milli sec" << std::endl;
     
+    // latest completed reference path; never waits for the reference path thread
+    const std::shared_ptr<const ReferencePath> reference_path_ptr = std::atomic_load(&reference_path_ptr_);
     
-    autoware_msgs::Lane out_trajectory;
-    std::vector<autoware_msgs::Lane> out_debug_trajectories;
-    std::vector<geometry_msgs::Point> out_target_points;
-    if(!only_testing_modified_global_path_ && got_modified_reference_path_)
+    autoware_msgs::Lane& out_trajectory = *out_lane_ptr_;
+    out_trajectory.waypoints.clear();
+    PlanningOutput& planning_output = *planning_output_ptr_;
+    planning_output.debug_trajectories.clear();
+    const bool has_marker_subscribers = markers_pub_.getNumSubscribers() > 0;
+    if(!only_testing_modified_global_path_ && reference_path_ptr)
     {
-      std::vector<autoware_msgs::Waypoint> local_reference_waypoints;
-      double min_dist = 99999;
-      size_t closest_wp_index = 0;
-      for (size_t i = 0; i < modified_reference_path_.size(); i++)
-      {
-        double dx = modified_reference_path_[i].pose.pose.position.x - in_pose_ptr_->pose.position.x;
-        double dy = modified_reference_path_[i].pose.pose.position.y - in_pose_ptr_->pose.position.y;
-        double distance = std::sqrt(std::pow(dx, 2)+std::pow(dy,2));
-        if(distance < min_dist)
+      const std::vector<autoware_msgs::Waypoint>& modified_reference_path = reference_path_ptr->waypoints;
+      const std::vector<Point>& center_line_points = reference_path_ptr->center_line_points;
+      const geometry_msgs::Point& ego_position = in_pose_ptr->pose.position;
+      const size_t closest_wp_index = reference_path_tracker_ptr_->findNearestIndex(
+        reference_path_ptr,
+        modified_reference_path.size(),
+        [&modified_reference_path, &ego_position](const size_t i)
         {
-          min_dist = distance;
-          closest_wp_index = i;
-        }
-      }
-      //TODO: think better way
-      for(size_t i = closest_wp_index; i< modified_reference_path_.size(); i++)
-      {
-        local_reference_waypoints.push_back(modified_reference_path_[i]);
-      }
+          return calculateSquared2DDistance(modified_reference_path[i].pose.pose.position, ego_position);
+        });
+      const size_t closest_point_index = center_line_tracker_ptr_->findNearestIndex(
+        reference_path_ptr,
+        center_line_points.size(),
+        [&center_line_points, &ego_position](const size_t i)
+        {
+          const double dx = center_line_points[i].tx - ego_position.x;
+          const double dy = center_line_points[i].ty - ego_position.y;
+          return dx*dx + dy*dy;
+        });
+      // parts ahead of the ego; views into reference_path_ptr, which outlives the planning call
+      const ArrayView<autoware_msgs::Waypoint> local_reference_waypoints(modified_reference_path, closest_wp_index);
+      const ArrayView<Point> local_center_points(center_line_points, closest_point_index);
       
-      std::vector<Point> local_center_points;
-      double min_dist2 = 99999;
-      size_t closest_point_index = 0;
-      for (size_t i = 0; i < center_line_points_.size(); i++)
+      
+      // // TODO: somehow improve interface
+      PlanningInput planning_input;
+      planning_input.current_pose = in_pose_ptr.get();
+      planning_input.current_twist = in_twist_ptr.get();
+      planning_input.lane_points = local_center_points;
+      planning_input.reference_waypoints = local_reference_waypoints;
+      planning_input.objects = in_objects_ptr.get();
+      planning_input.collects_debug_trajectories = has_marker_subscribers;
+      if(in_objects_ptr && object_corridor_margin_ > 0)
       {
-        double dx = center_line_points_[i].tx - in_pose_ptr_->pose.position.x;
-        double dy = center_line_points_[i].ty - in_pose_ptr_->pose.position.y;
-        double distance = std::sqrt(std::pow(dx, 2)+std::pow(dy,2));
-        if(distance < min_dist)
-        {
-          min_dist2 = distance;
-          closest_point_index = i;
-        }
+        cullObjectsOutsideCorridor(*in_objects_ptr,
+                                   local_reference_waypoints,
+                                   object_corridor_margin_,
+                                   *corridor_objects_ptr_);
+        ROS_DEBUG("objects in corridor %zu / %zu",
+                  corridor_objects_ptr_->objects.size(),
+                  in_objects_ptr->objects.size());
+        planning_input.objects = corridor_objects_ptr_.get();
       }
-      //TODO: think better way
-      for(size_t i = closest_point_index; i< center_line_points_.size(); i++)
+      if(!frenet_planner_ptr_->plan(planning_input, planning_output))
       {
-        local_center_points.push_back(center_line_points_[i]);
+        std::cerr << "ERROR: " << planning_output.error_message << std::endl;
       }
-      
-      
-      // // TODO: somehow improve interface
-      frenet_planner_ptr_->doPlan(*in_pose_ptr_, 
-                                  *in_twist_ptr_, 
-                                  local_center_points, 
-                                  local_reference_waypoints,
-                                  in_objects_ptr_,
-                                  out_trajectory,
-                                  out_debug_trajectories,
-                                  out_target_points);
+      out_trajectory.waypoints.swap(planning_output.trajectory.waypoints);
       std::cerr << "------"  << std::endl;
       // for(auto& trajectory: out_trajectory.waypoints)
       // {
@@ -424,407 +918,440 @@ void FrenetPlannerROS::timerCallback(const ros::TimerEvent &e)
       // std::cerr << "output num wps" << out_trajectory.waypoints.size() << std::endl;
       std::cerr << "------------"  << std::endl;
       
-      autoware_msgs::Lane dummy_lane = *in_waypoints_ptr_;
-      dummy_lane.waypoints = local_reference_waypoints;
-      dummy_lane.waypoints = out_trajectory.waypoints;
-      optimized_waypoints_pub_.publish(dummy_lane);
+      // everything but the waypoints comes from the global lane
+      out_trajectory.header = in_waypoints_ptr->header;
+      out_trajectory.increment = in_waypoints_ptr->increment;
+      out_trajectory.lane_id = in_waypoints_ptr->lane_id;
+      out_trajectory.lane_index = in_waypoints_ptr->lane_index;
+      out_trajectory.cost = in_waypoints_ptr->cost;
+      out_trajectory.closest_object_distance = in_waypoints_ptr->closest_object_distance;
+      out_trajectory.closest_object_velocity = in_waypoints_ptr->closest_object_velocity;
+      out_trajectory.is_blocked = in_waypoints_ptr->is_blocked;
+      optimized_waypoints_pub_.publish(out_trajectory);
+      
+      // age of the sensor data the published trajectory is based on
+      const ros::Time publish_time = ros::Time::now();
+      if(pose_latency_statistics_ptr_->add((publish_time - in_pose_ptr->header.stamp).toSec()))
+      {
+        ROS_INFO("%s", pose_latency_statistics_ptr_->getReport().c_str());
+      }
+      if(in_objects_ptr &&
+         objects_latency_statistics_ptr_->add((publish_time - in_objects_ptr->header.stamp).toSec()))
+      {
+        ROS_INFO("%s", objects_latency_statistics_ptr_->getReport().c_str());
+      }
     }
     // optimized_waypoints_pub_.publish(out_trajectory);
     
     
     
-    //debug; marker array
-    visualization_msgs::MarkerArray points_marker_array;
-    int unique_id = 0;
+    // markers are built from a snapshot, either here or on the debug thread
+    if(has_marker_subscribers)
+    {
+      std::shared_ptr<DebugOutput> debug_output_ptr = std::make_shared<DebugOutput>();
+      debug_output_ptr->header = in_pose_ptr->header;
+      debug_output_ptr->trajectory_points.reserve(out_trajectory.waypoints.size());
+      for(const auto& waypoint: out_trajectory.waypoints)
+      {
+        debug_output_ptr->trajectory_points.push_back(waypoint.pose.pose.position);
+      }
+      // handed over to the debug thread; only filled while markers are subscribed
+      debug_output_ptr->debug_trajectories = std::move(planning_output.debug_trajectories);
+      debug_output_ptr->reference_path_ptr = reference_path_ptr;
+      if(debug_thread_.joinable())
+      {
+        debug_output_mailbox_.post(debug_output_ptr);
+      }
+      else
+      {
+        publishDebugMarkers(*debug_output_ptr);
+      }
+    }
+  }
+}
+
+void FrenetPlannerROS::publishDebugMarkers(const DebugOutput& debug_output)
+{
+  //debug; marker array
+  visualization_msgs::MarkerArray& points_marker_array = *out_marker_array_ptr_;
+  int unique_id = 0;
+  
+  // // visualize debug modified reference point
+  // visualization_msgs::Marker debug_a_star_marker;
+  // debug_a_star_marker.lifetime = ros::Duration(0.2);
+  // debug_a_star_marker.header = in_pose_ptr->header;
+  // debug_a_star_marker.ns = std::string("debug_a_star_marker");
+  // debug_a_star_marker.action = visualization_msgs::Marker::MODIFY;
+  // debug_a_star_marker.pose.orientation.w = 1.0;
+  // debug_a_star_marker.id = unique_id;
+  // debug_a_star_marker.type = visualization_msgs::Marker::SPHERE_LIST;
+  // debug_a_star_marker.scale.x = 0.9;
+  // debug_a_star_marker.color.r = 1.0f;
+  // debug_a_star_marker.color.g = 1.0f;
+  // debug_a_star_marker.color.a = 1;
+  // for(const auto& waypoint: debug_astar_path)
+  // {
+  //   debug_a_star_marker.points.push_back(waypoint.pose.pose.position);
+  // }
+  // points_marker_array.markers.push_back(debug_a_star_marker);
+  // unique_id++;
+  
+  // //text astar path
+  // for (const auto& point: debug_astar_path)
+  // {
+  //   visualization_msgs::Marker debug_astar_clearance_text_marker;
+  //   debug_astar_clearance_text_marker.lifetime = ros::Duration(0.2);
+  //   debug_astar_clearance_text_marker.header = in_pose_ptr->header;
+  //   debug_astar_clearance_text_marker.ns = std::string("debug_astar_clearance_text_marker");
+  //   debug_astar_clearance_text_marker.action = visualization_msgs::Marker::ADD;
+  //   debug_astar_clearance_text_marker.id = unique_id;
+  //   debug_astar_clearance_text_marker.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  //   debug_astar_clearance_text_marker.scale.x = 1;
+  //   debug_astar_clearance_text_marker.scale.y = 0.1;
+  //   debug_astar_clearance_text_marker.scale.z = 0.4;
+
+  //   // texts are green
+  //   debug_astar_clearance_text_marker.color.g = 1.0f;
+  //   debug_astar_clearance_text_marker.color.a = 1.0;
     
-    // // visualize debug modified reference point
-    // visualization_msgs::Marker debug_a_star_marker;
-    // debug_a_star_marker.lifetime = ros::Duration(0.2);
-    // debug_a_star_marker.header = in_pose_ptr_->header;
-    // debug_a_star_marker.ns = std::string("debug_a_star_marker");
-    // debug_a_star_marker.action = visualization_msgs::Marker::MODIFY;
-    // debug_a_star_marker.pose.orientation.w = 1.0;
-    // debug_a_star_marker.id = unique_id;
-    // debug_a_star_marker.type = visualization_msgs::Marker::SPHERE_LIST;
-    // debug_a_star_marker.scale.x = 0.9;
-    // debug_a_star_marker.color.r = 1.0f;
-    // debug_a_star_marker.color.g = 1.0f;
-    // debug_a_star_marker.color.a = 1;
-    // for(const auto& waypoint: debug_astar_path)
-    // {
-    //   debug_a_star_marker.points.push_back(waypoint.pose.pose.position);
-    // }
-    // points_marker_array.markers.push_back(debug_a_star_marker);
-    // unique_id++;
     
-    // //text astar path
-    // for (const auto& point: debug_astar_path)
-    // {
-    //   visualization_msgs::Marker debug_astar_clearance_text_marker;
-    //   debug_astar_clearance_text_marker.lifetime = ros::Duration(0.2);
-    //   debug_astar_clearance_text_marker.header = in_pose_ptr_->header;
-    //   debug_astar_clearance_text_marker.ns = std::string("debug_astar_clearance_text_marker");
-    //   debug_astar_clearance_text_marker.action = visualization_msgs::Marker::ADD;
-    //   debug_astar_clearance_text_marker.id = unique_id;
-    //   debug_astar_clearance_text_marker.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    //   debug_astar_clearance_text_marker.scale.x = 1;
-    //   debug_astar_clearance_text_marker.scale.y = 0.1;
-    //   debug_astar_clearance_text_marker.scale.z = 0.4;
-
-    //   // texts are green
-    //   debug_astar_clearance_text_marker.color.g = 1.0f;
-    //   debug_astar_clearance_text_marker.color.a = 1.0;
-      
-      
-    //   geometry_msgs::Point relative_p;
-    //   relative_p.y = 0.8;
-    //   geometry_msgs::Pose pose;
-    //   pose.position = point.pose.pose.position;
-    //   pose.orientation.x = 0;
-    //   pose.orientation.y = 0;
-    //   pose.orientation.z = 0;
-    //   pose.orientation.w = 1.0;
-    //   tf::Transform inverse;
-    //   tf::poseMsgToTF(pose, inverse);
-
-    //   tf::Point p;
-    //   pointMsgToTF(relative_p, p);
-    //   tf::Point tf_p = inverse * p;
-    //   geometry_msgs::Point tf_point_msg;
-    //   pointTFToMsg(tf_p, tf_point_msg);
-    //   debug_astar_clearance_text_marker.pose.position = tf_point_msg;
-    //   debug_astar_clearance_text_marker.text = std::to_string(point.cost);
-      
-    //   unique_id++;
-      
-    //   points_marker_array.markers.push_back(debug_astar_clearance_text_marker); 
-    // }
-       
-    // visualize debug modified reference point
-    visualization_msgs::Marker debug_modified_reference_points;
-    debug_modified_reference_points.lifetime = ros::Duration(0.2);
-    debug_modified_reference_points.header = in_pose_ptr_->header;
-    debug_modified_reference_points.ns = std::string("debug_modified_reference_points");
-    debug_modified_reference_points.action = visualization_msgs::Marker::MODIFY;
-    debug_modified_reference_points.pose.orientation.w = 1.0;
-    debug_modified_reference_points.id = unique_id;
-    debug_modified_reference_points.type = visualization_msgs::Marker::SPHERE_LIST;
-    debug_modified_reference_points.scale.x = 0.9;
-    debug_modified_reference_points.color.r = 1.0f;
-    debug_modified_reference_points.color.g = 1.0f;
-    debug_modified_reference_points.color.a = 1;
-    for(const auto& waypoint: modified_reference_path_)
+  //   geometry_msgs::Point relative_p;
+  //   relative_p.y = 0.8;
+  //   geometry_msgs::Pose pose;
+  //   pose.position = point.pose.pose.position;
+  //   pose.orientation.x = 0;
+  //   pose.orientation.y = 0;
+  //   pose.orientation.z = 0;
+  //   pose.orientation.w = 1.0;
+  //   tf::Transform inverse;
+  //   tf::poseMsgToTF(pose, inverse);
+
+  //   tf::Point p;
+  //   pointMsgToTF(relative_p, p);
+  //   tf::Point tf_p = inverse * p;
+  //   geometry_msgs::Point tf_point_msg;
+  //   pointTFToMsg(tf_p, tf_point_msg);
+  //   debug_astar_clearance_text_marker.pose.position = tf_point_msg;
+  //   debug_astar_clearance_text_marker.text = std::to_string(point.cost);
+    
+  //   unique_id++;
+    
+  //   points_marker_array.markers.push_back(debug_astar_clearance_text_marker); 
+  // }
+     
+  // visualize debug modified reference point
+  visualization_msgs::Marker& debug_modified_reference_points = reuseMarker(points_marker_array, unique_id);
+  debug_modified_reference_points.lifetime = ros::Duration(0.2);
+  debug_modified_reference_points.header = debug_output.header;
+  debug_modified_reference_points.ns = std::string("debug_modified_reference_points");
+  debug_modified_reference_points.action = visualization_msgs::Marker::MODIFY;
+  debug_modified_reference_points.pose.orientation.w = 1.0;
+  debug_modified_reference_points.id = unique_id;
+  debug_modified_reference_points.type = visualization_msgs::Marker::SPHERE_LIST;
+  debug_modified_reference_points.scale.x = 0.9;
+  debug_modified_reference_points.color.r = 1.0f;
+  debug_modified_reference_points.color.g = 1.0f;
+  debug_modified_reference_points.color.a = 1;
+  if(debug_output.reference_path_ptr)
+  {
+    for(const auto& waypoint: debug_output.reference_path_ptr->waypoints)
     {
       debug_modified_reference_points.points.push_back(waypoint.pose.pose.position);
     }
-    points_marker_array.markers.push_back(debug_modified_reference_points);
-    unique_id++;
+  }
+  unique_id++;
+  
+  //  // visualize debug modified smoothed reference point
+  // visualization_msgs::Marker debug_modified_smoothed_reference_points;
+  // debug_modified_smoothed_reference_points.lifetime = ros::Duration(0.2);
+  // debug_modified_smoothed_reference_points.header = in_pose_ptr->header;
+  // debug_modified_smoothed_reference_points.ns = std::string("debug_modified_smoothed_reference_points");
+  // debug_modified_smoothed_reference_points.action = visualization_msgs::Marker::MODIFY;
+  // debug_modified_smoothed_reference_points.pose.orientation.w = 1.0;
+  // debug_modified_smoothed_reference_points.id = unique_id;
+  // debug_modified_smoothed_reference_points.type = visualization_msgs::Marker::SPHERE_LIST;
+  // debug_modified_smoothed_reference_points.scale.x = 0.9;
+  // debug_modified_smoothed_reference_points.color.r = 1.0f;
+  // debug_modified_smoothed_reference_points.color.a = 0.6;
+  // for(const auto& waypoint: debug_modified_smoothed_reference_path)
+  // {
+  //   debug_modified_smoothed_reference_points.points.push_back(waypoint.pose.pose.position);
+  // }
+  // points_marker_array.markers.push_back(debug_modified_smoothed_reference_points);
+  // unique_id++;
+  
+  //  // visualize debug bspline
+  // visualization_msgs::Marker debug_bspline_path_marker;
+  // debug_bspline_path_marker.lifetime = ros::Duration(0.2);
+  // debug_bspline_path_marker.header = in_pose_ptr->header;
+  // debug_bspline_path_marker.ns = std::string("debug_bspline_path_marker");
+  // debug_bspline_path_marker.action = visualization_msgs::Marker::MODIFY;
+  // debug_bspline_path_marker.pose.orientation.w = 1.0;
+  // debug_bspline_path_marker.id = unique_id;
+  // debug_bspline_path_marker.type = visualization_msgs::Marker::SPHERE_LIST;
+  // debug_bspline_path_marker.scale.x = 0.9;
+  // debug_bspline_path_marker.color.r = 1.0f;
+  // debug_bspline_path_marker.color.a = 1;
+  // for(const auto& waypoint: debug_bspline_path)
+  // {
+  //   debug_bspline_path_marker.points.push_back(waypoint.pose.pose.position);
+  // }
+  // points_marker_array.markers.push_back(debug_bspline_path_marker);
+  // unique_id++;
+  
+  // //text modified reference path curvature
+  // for (const auto& point: debug_modified_smoothed_reference_path)
+  // {
+  //   visualization_msgs::Marker debuf_modified_curvature_text;
+  //   debuf_modified_curvature_text.lifetime = ros::Duration(0.2);
+  //   debuf_modified_curvature_text.header = in_pose_ptr->header;
+  //   debuf_modified_curvature_text.ns = std::string("debuf_modified_curvature_text");
+  //   debuf_modified_curvature_text.action = visualization_msgs::Marker::ADD;
+  //   debuf_modified_curvature_text.id = unique_id;
+  //   debuf_modified_curvature_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  //   debuf_modified_curvature_text.scale.x = 1;
+  //   debuf_modified_curvature_text.scale.y = 0.1;
+  //   debuf_modified_curvature_text.scale.z = 0.4;
+
+  //   // texts are green
+  //   debuf_modified_curvature_text.color.g = 1.0f;
+  //   debuf_modified_curvature_text.color.a = 1.0;
     
-    //  // visualize debug modified smoothed reference point
-    // visualization_msgs::Marker debug_modified_smoothed_reference_points;
-    // debug_modified_smoothed_reference_points.lifetime = ros::Duration(0.2);
-    // debug_modified_smoothed_reference_points.header = in_pose_ptr_->header;
-    // debug_modified_smoothed_reference_points.ns = std::string("debug_modified_smoothed_reference_points");
-    // debug_modified_smoothed_reference_points.action = visualization_msgs::Marker::MODIFY;
-    // debug_modified_smoothed_reference_points.pose.orientation.w = 1.0;
-    // debug_modified_smoothed_reference_points.id = unique_id;
-    // debug_modified_smoothed_reference_points.type = visualization_msgs::Marker::SPHERE_LIST;
-    // debug_modified_smoothed_reference_points.scale.x = 0.9;
-    // debug_modified_smoothed_reference_points.color.r = 1.0f;
-    // debug_modified_smoothed_reference_points.color.a = 0.6;
-    // for(const auto& waypoint: debug_modified_smoothed_reference_path)
-    // {
-    //   debug_modified_smoothed_reference_points.points.push_back(waypoint.pose.pose.position);
-    // }
-    // points_marker_array.markers.push_back(debug_modified_smoothed_reference_points);
-    // unique_id++;
     
-    //  // visualize debug bspline
-    // visualization_msgs::Marker debug_bspline_path_marker;
-    // debug_bspline_path_marker.lifetime = ros::Duration(0.2);
-    // debug_bspline_path_marker.header = in_pose_ptr_->header;
-    // debug_bspline_path_marker.ns = std::string("debug_bspline_path_marker");
-    // debug_bspline_path_marker.action = visualization_msgs::Marker::MODIFY;
-    // debug_bspline_path_marker.pose.orientation.w = 1.0;
-    // debug_bspline_path_marker.id = unique_id;
-    // debug_bspline_path_marker.type = visualization_msgs::Marker::SPHERE_LIST;
-    // debug_bspline_path_marker.scale.x = 0.9;
-    // debug_bspline_path_marker.color.r = 1.0f;
-    // debug_bspline_path_marker.color.a = 1;
-    // for(const auto& waypoint: debug_bspline_path)
-    // {
-    //   debug_bspline_path_marker.points.push_back(waypoint.pose.pose.position);
-    // }
-    // points_marker_array.markers.push_back(debug_bspline_path_marker);
-    // unique_id++;
+  //   geometry_msgs::Point relative_p;
+  //   relative_p.y = 0.8;
+  //   geometry_msgs::Pose pose;
+  //   pose.position = point.pose.pose.position;
+  //   pose.orientation.x = 0;
+  //   pose.orientation.y = 0;
+  //   pose.orientation.z = 0;
+  //   pose.orientation.w = 1.0;
+  //   tf::Transform inverse;
+  //   tf::poseMsgToTF(pose, inverse);
+
+  //   tf::Point p;
+  //   pointMsgToTF(relative_p, p);
+  //   tf::Point tf_p = inverse * p;
+  //   geometry_msgs::Point tf_point_msg;
+  //   pointTFToMsg(tf_p, tf_point_msg);
+  //   debuf_modified_curvature_text.pose.position = tf_point_msg;
+  //   debuf_modified_curvature_text.text = std::to_string(point.cost);
     
-    // //text modified reference path curvature
-    // for (const auto& point: debug_modified_smoothed_reference_path)
-    // {
-    //   visualization_msgs::Marker debuf_modified_curvature_text;
-    //   debuf_modified_curvature_text.lifetime = ros::Duration(0.2);
-    //   debuf_modified_curvature_text.header = in_pose_ptr_->header;
-    //   debuf_modified_curvature_text.ns = std::string("debuf_modified_curvature_text");
-    //   debuf_modified_curvature_text.action = visualization_msgs::Marker::ADD;
-    //   debuf_modified_curvature_text.id = unique_id;
-    //   debuf_modified_curvature_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    //   debuf_modified_curvature_text.scale.x = 1;
-    //   debuf_modified_curvature_text.scale.y = 0.1;
-    //   debuf_modified_curvature_text.scale.z = 0.4;
-
-    //   // texts are green
-    //   debuf_modified_curvature_text.color.g = 1.0f;
-    //   debuf_modified_curvature_text.color.a = 1.0;
-      
-      
-    //   geometry_msgs::Point relative_p;
-    //   relative_p.y = 0.8;
-    //   geometry_msgs::Pose pose;
-    //   pose.position = point.pose.pose.position;
-    //   pose.orientation.x = 0;
-    //   pose.orientation.y = 0;
-    //   pose.orientation.z = 0;
-    //   pose.orientation.w = 1.0;
-    //   tf::Transform inverse;
-    //   tf::poseMsgToTF(pose, inverse);
-
-    //   tf::Point p;
-    //   pointMsgToTF(relative_p, p);
-    //   tf::Point tf_p = inverse * p;
-    //   geometry_msgs::Point tf_point_msg;
-    //   pointTFToMsg(tf_p, tf_point_msg);
-    //   debuf_modified_curvature_text.pose.position = tf_point_msg;
-    //   debuf_modified_curvature_text.text = std::to_string(point.cost);
-      
-    //   unique_id++;
-      
-    //   points_marker_array.markers.push_back(debuf_modified_curvature_text); 
-    // }
+  //   unique_id++;
     
-    // // visualize debug goal point
-    // visualization_msgs::Marker debug_goal_point;
-    // debug_goal_point.lifetime = ros::Duration(0.2);
-    // debug_goal_point.header = in_pose_ptr_->header;
-    // debug_goal_point.ns = std::string("debug_goal_point_marker");
-    // debug_goal_point.action = visualization_msgs::Marker::MODIFY;
-    // debug_goal_point.pose.orientation.w = 1.0;
-    // debug_goal_point.id = unique_id;
-    // debug_goal_point.type = visualization_msgs::Marker::SPHERE_LIST;
-    // debug_goal_point.scale.x = 0.9;
-    // debug_goal_point.color.r = 0.0f;
-    // debug_goal_point.color.g = 1.0f;
-    // debug_goal_point.color.a = 1;
-    // debug_goal_point.points.push_back(goal_point);
-    // points_marker_array.markers.push_back(debug_goal_point);
-    // unique_id++;
+  //   points_marker_array.markers.push_back(debuf_modified_curvature_text); 
+  // }
+  
+  // // visualize debug goal point
+  // visualization_msgs::Marker debug_goal_point;
+  // debug_goal_point.lifetime = ros::Duration(0.2);
+  // debug_goal_point.header = in_pose_ptr->header;
+  // debug_goal_point.ns = std::string("debug_goal_point_marker");
+  // debug_goal_point.action = visualization_msgs::Marker::MODIFY;
+  // debug_goal_point.pose.orientation.w = 1.0;
+  // debug_goal_point.id = unique_id;
+  // debug_goal_point.type = visualization_msgs::Marker::SPHERE_LIST;
+  // debug_goal_point.scale.x = 0.9;
+  // debug_goal_point.color.r = 0.0f;
+  // debug_goal_point.color.g = 1.0f;
+  // debug_goal_point.color.a = 1;
+  // debug_goal_point.points.push_back(goal_point);
+  // points_marker_array.markers.push_back(debug_goal_point);
+  // unique_id++;
+  
+  // //text
+  // size_t debug_reference_point_id = 0;
+  // for (const auto& point: out_target_points)
+  // {
+  //   visualization_msgs::Marker debug_reference_point_text;
+  //   debug_reference_point_text.lifetime = ros::Duration(0.2);
+  //   debug_reference_point_text.header = in_pose_ptr->header;
+  //   debug_reference_point_text.ns = std::string("debug_reference_point_text");
+  //   debug_reference_point_text.action = visualization_msgs::Marker::ADD;
+  //   debug_reference_point_text.id = unique_id;
+  //   debug_reference_point_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  //   debug_reference_point_text.scale.x = 1;
+  //   debug_reference_point_text.scale.y = 0.1;
+  //   debug_reference_point_text.scale.z = 0.4;
+
+  //   // texts are green
+  //   debug_reference_point_text.color.g = 1.0f;
+  //   debug_reference_point_text.color.a = 1.0;
     
-    // //text
-    // size_t debug_reference_point_id = 0;
-    // for (const auto& point: out_target_points)
-    // {
-    //   visualization_msgs::Marker debug_reference_point_text;
-    //   debug_reference_point_text.lifetime = ros::Duration(0.2);
-    //   debug_reference_point_text.header = in_pose_ptr_->header;
-    //   debug_reference_point_text.ns = std::string("debug_reference_point_text");
-    //   debug_reference_point_text.action = visualization_msgs::Marker::ADD;
-    //   debug_reference_point_text.id = unique_id;
-    //   debug_reference_point_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    //   debug_reference_point_text.scale.x = 1;
-    //   debug_reference_point_text.scale.y = 0.1;
-    //   debug_reference_point_text.scale.z = 0.4;
-
-    //   // texts are green
-    //   debug_reference_point_text.color.g = 1.0f;
-    //   debug_reference_point_text.color.a = 1.0;
-      
-      
-    //   geometry_msgs::Point relative_p;
-    //   relative_p.y = 0.8;
-    //   geometry_msgs::Pose pose;
-    //   pose.position = point;
-    //   pose.orientation.x = 0;
-    //   pose.orientation.y = 0;
-    //   pose.orientation.z = 0;
-    //   pose.orientation.w = 1.0;
-    //   tf::Transform inverse;
-    //   tf::poseMsgToTF(pose, inverse);
-
-    //   tf::Point p;
-    //   pointMsgToTF(relative_p, p);
-    //   tf::Point tf_p = inverse * p;
-    //   geometry_msgs::Point tf_point_msg;
-    //   pointTFToMsg(tf_p, tf_point_msg);
-    //   debug_reference_point_text.pose.position = tf_point_msg;
-    //   debug_reference_point_text.text = std::to_string(debug_reference_point_id);
-    //   debug_reference_point_id ++;
-      
-    //   unique_id++;
-      
-    //   points_marker_array.markers.push_back(debug_reference_point_text); 
-    // }
     
-    // //center point text
-    // size_t debug_global_point_id = 0;
-    // for (const auto& point: local_center_points)
-    // {
-    //   visualization_msgs::Marker debug_center_point_text;
-    //   debug_center_point_text.lifetime = ros::Duration(0.2);
-    //   debug_center_point_text.header = in_pose_ptr_->header;
-    //   debug_center_point_text.ns = std::string("debug_center_point_text");
-    //   debug_center_point_text.action = visualization_msgs::Marker::ADD;
-    //   debug_center_point_text.id = unique_id;
-    //   debug_center_point_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    //   debug_center_point_text.scale.x = 1;
-    //   debug_center_point_text.scale.y = 0.1;
-    //   debug_center_point_text.scale.z = 0.4;
-
-    //   // texts are green
-    //   debug_center_point_text.color.g = 1.0f;
-    //   debug_center_point_text.color.a = 1.0;
-      
-      
-    //   geometry_msgs::Point relative_p;
-    //   relative_p.y = 0.8;
-    //   geometry_msgs::Pose pose;
-    //   pose.position.x = point.tx ;
-    //   pose.position.y = point.ty ;
-    //   pose.position.z = in_waypoints_ptr_->waypoints.front().pose.pose.position.z;
-    //   pose.orientation.x = 0;
-    //   pose.orientation.y = 0;
-    //   pose.orientation.z = 0;
-    //   pose.orientation.w = 1.0;
-    //   tf::Transform inverse;
-    //   tf::poseMsgToTF(pose, inverse);
-
-    //   tf::Point p;
-    //   pointMsgToTF(relative_p, p);
-    //   tf::Point tf_p = inverse * p;
-    //   geometry_msgs::Point tf_point_msg;
-    //   pointTFToMsg(tf_p, tf_point_msg);
-    //   debug_center_point_text.pose.position = tf_point_msg;
-    //   debug_center_point_text.text = std::to_string(point.cumulated_s).substr(0, 5);
-    //   // debug_center_point_text.text += std::string(" ");
-    //   // debug_center_point_text.text += std::to_string(point.tx);
-    //   // debug_center_point_text.text += std::string(" ");
-    //   // debug_center_point_text.text += std::to_string(point.ty);
-      
-    //   debug_global_point_id ++;
-      
-    //   unique_id++;
-      
-    //   points_marker_array.markers.push_back(debug_center_point_text); 
-    // }
+  //   geometry_msgs::Point relative_p;
+  //   relative_p.y = 0.8;
+  //   geometry_msgs::Pose pose;
+  //   pose.position = point;
+  //   pose.orientation.x = 0;
+  //   pose.orientation.y = 0;
+  //   pose.orientation.z = 0;
+  //   pose.orientation.w = 1.0;
+  //   tf::Transform inverse;
+  //   tf::poseMsgToTF(pose, inverse);
 
+  //   tf::Point p;
+  //   pointMsgToTF(relative_p, p);
+  //   tf::Point tf_p = inverse * p;
+  //   geometry_msgs::Point tf_point_msg;
+  //   pointTFToMsg(tf_p, tf_point_msg);
+  //   debug_reference_point_text.pose.position = tf_point_msg;
+  //   debug_reference_point_text.text = std::to_string(debug_reference_point_id);
+  //   debug_reference_point_id ++;
     
+  //   unique_id++;
     
-    // //text
-    // size_t debug_wp_id = 0;
-    // for (const auto& waypoint: out_trajectory.waypoints)
-    // {
-    //   visualization_msgs::Marker trajectory_points_text;
-    //   trajectory_points_text.lifetime = ros::Duration(0.2);
-    //   trajectory_points_text.header = in_pose_ptr_->header;
-    //   trajectory_points_text.ns = std::string("trajectory_points_text");
-    //   trajectory_points_text.action = visualization_msgs::Marker::ADD;
-    //   trajectory_points_text.id = unique_id;
-    //   trajectory_points_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    //   trajectory_points_text.scale.x = 1;
-    //   trajectory_points_text.scale.y = 0.1;
-    //   trajectory_points_text.scale.z = 0.4;
-
-    //   // texts are green
-    //   trajectory_points_text.color.g = 1.0f;
-    //   trajectory_points_text.color.a = 1.0;
-      
-    //   double velocity_in_kmh = (waypoint.twist.twist.linear.x*60*60)/(1000);
-      
-    //   geometry_msgs::Point relative_p;
-    //   relative_p.y = 0.8;
-    //   geometry_msgs::Pose pose = waypoint.pose.pose;
-    //   tf::Transform inverse;
-    //   tf::poseMsgToTF(pose, inverse);
-
-    //   tf::Point p;
-    //   pointMsgToTF(relative_p, p);
-    //   tf::Point tf_p = inverse * p;
-    //   geometry_msgs::Point tf_point_msg;
-    //   pointTFToMsg(tf_p, tf_point_msg);
-    //   trajectory_points_text.pose.position = tf_point_msg;
-    //   trajectory_points_text.text = std::to_string(debug_wp_id);
-    //   trajectory_points_text.text += std::string(": ");
-      
-    //   trajectory_points_text.text += 
-    //     std::to_string(velocity_in_kmh).substr(0,4);
-        
-    //   // trajectory_points_text.text += std::string(" ");
-    //   // trajectory_points_text.text += std::to_string(pose.position.x);
-    //   // trajectory_points_text.text += std::string(" ");
-    //   // trajectory_points_text.text += std::to_string(pose.position.y);
-      
-    //   // trajectory_points_text.pose.orientation = waypoint.pose.pose.orientation;
-    //   unique_id++;
-      
-    //   points_marker_array.markers.push_back(trajectory_points_text);
+  //   points_marker_array.markers.push_back(debug_reference_point_text); 
+  // }
+  
+  // //center point text
+  // size_t debug_global_point_id = 0;
+  // for (const auto& point: local_center_points)
+  // {
+  //   visualization_msgs::Marker debug_center_point_text;
+  //   debug_center_point_text.lifetime = ros::Duration(0.2);
+  //   debug_center_point_text.header = in_pose_ptr->header;
+  //   debug_center_point_text.ns = std::string("debug_center_point_text");
+  //   debug_center_point_text.action = visualization_msgs::Marker::ADD;
+  //   debug_center_point_text.id = unique_id;
+  //   debug_center_point_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  //   debug_center_point_text.scale.x = 1;
+  //   debug_center_point_text.scale.y = 0.1;
+  //   debug_center_point_text.scale.z = 0.4;
+
+  //   // texts are green
+  //   debug_center_point_text.color.g = 1.0f;
+  //   debug_center_point_text.color.a = 1.0;
+    
+    
+  //   geometry_msgs::Point relative_p;
+  //   relative_p.y = 0.8;
+  //   geometry_msgs::Pose pose;
+  //   pose.position.x = point.tx ;
+  //   pose.position.y = point.ty ;
+  //   pose.position.z = in_waypoints_ptr->waypoints.front().pose.pose.position.z;
+  //   pose.orientation.x = 0;
+  //   pose.orientation.y = 0;
+  //   pose.orientation.z = 0;
+  //   pose.orientation.w = 1.0;
+  //   tf::Transform inverse;
+  //   tf::poseMsgToTF(pose, inverse);
+
+  //   tf::Point p;
+  //   pointMsgToTF(relative_p, p);
+  //   tf::Point tf_p = inverse * p;
+  //   geometry_msgs::Point tf_point_msg;
+  //   pointTFToMsg(tf_p, tf_point_msg);
+  //   debug_center_point_text.pose.position = tf_point_msg;
+  //   debug_center_point_text.text = std::to_string(point.cumulated_s).substr(0, 5);
+  //   // debug_center_point_text.text += std::string(" ");
+  //   // debug_center_point_text.text += std::to_string(point.tx);
+  //   // debug_center_point_text.text += std::string(" ");
+  //   // debug_center_point_text.text += std::to_string(point.ty);
+    
+  //   debug_global_point_id ++;
+    
+  //   unique_id++;
+    
+  //   points_marker_array.markers.push_back(debug_center_point_text); 
+  // }
+
+  
+  
+  // //text
+  // size_t debug_wp_id = 0;
+  // for (const auto& waypoint: out_trajectory.waypoints)
+  // {
+  //   visualization_msgs::Marker trajectory_points_text;
+  //   trajectory_points_text.lifetime = ros::Duration(0.2);
+  //   trajectory_points_text.header = in_pose_ptr->header;
+  //   trajectory_points_text.ns = std::string("trajectory_points_text");
+  //   trajectory_points_text.action = visualization_msgs::Marker::ADD;
+  //   trajectory_points_text.id = unique_id;
+  //   trajectory_points_text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  //   trajectory_points_text.scale.x = 1;
+  //   trajectory_points_text.scale.y = 0.1;
+  //   trajectory_points_text.scale.z = 0.4;
+
+  //   // texts are green
+  //   trajectory_points_text.color.g = 1.0f;
+  //   trajectory_points_text.color.a = 1.0;
+    
+  //   double velocity_in_kmh = (waypoint.twist.twist.linear.x*60*60)/(1000);
+    
+  //   geometry_msgs::Point relative_p;
+  //   relative_p.y = 0.8;
+  //   geometry_msgs::Pose pose = waypoint.pose.pose;
+  //   tf::Transform inverse;
+  //   tf::poseMsgToTF(pose, inverse);
+
+  //   tf::Point p;
+  //   pointMsgToTF(relative_p, p);
+  //   tf::Point tf_p = inverse * p;
+  //   geometry_msgs::Point tf_point_msg;
+  //   pointTFToMsg(tf_p, tf_point_msg);
+  //   trajectory_points_text.pose.position = tf_point_msg;
+  //   trajectory_points_text.text = std::to_string(debug_wp_id);
+  //   trajectory_points_text.text += std::string(": ");
+    
+  //   trajectory_points_text.text += 
+  //     std::to_string(velocity_in_kmh).substr(0,4);
       
-    //   debug_wp_id++;
-    // }
+  //   // trajectory_points_text.text += std::string(" ");
+  //   // trajectory_points_text.text += std::to_string(pose.position.x);
+  //   // trajectory_points_text.text += std::string(" ");
+  //   // trajectory_points_text.text += std::to_string(pose.position.y);
     
-    visualization_msgs::Marker trajectory_marker;
-    trajectory_marker.lifetime = ros::Duration(0.2);
-    trajectory_marker.header = in_pose_ptr_->header;
-    trajectory_marker.ns = std::string("trajectory_marker");
-    trajectory_marker.action = visualization_msgs::Marker::MODIFY;
-    trajectory_marker.pose.orientation.w = 1.0;
-    trajectory_marker.id = unique_id;
-    trajectory_marker.type = visualization_msgs::Marker::SPHERE_LIST;
-    trajectory_marker.scale.x = 0.6;
-
-    // Points are red
-    trajectory_marker.color.r = 1.0f;
-    trajectory_marker.color.a = 1;
-    for (const auto& waypoint: out_trajectory.waypoints)
-    {
-      geometry_msgs::Point geometry_point;
-      geometry_point.x = waypoint.pose.pose.position.x;
-      geometry_point.y = waypoint.pose.pose.position.y;
-      geometry_point.z = waypoint.pose.pose.position.z;
-      trajectory_marker.points.push_back(geometry_point);
-    }
-    points_marker_array.markers.push_back(trajectory_marker);
-    unique_id++;
+  //   // trajectory_points_text.pose.orientation = waypoint.pose.pose.orientation;
+  //   unique_id++;
+    
+  //   points_marker_array.markers.push_back(trajectory_points_text);
     
-    int trajectory_count = 0;
-    for(const auto& trajectory: out_debug_trajectories)
+  //   debug_wp_id++;
+  // }
+  
+  visualization_msgs::Marker& trajectory_marker = reuseMarker(points_marker_array, unique_id);
+  trajectory_marker.lifetime = ros::Duration(0.2);
+  trajectory_marker.header = debug_output.header;
+  trajectory_marker.ns = std::string("trajectory_marker");
+  trajectory_marker.action = visualization_msgs::Marker::MODIFY;
+  trajectory_marker.pose.orientation.w = 1.0;
+  trajectory_marker.id = unique_id;
+  trajectory_marker.type = visualization_msgs::Marker::SPHERE_LIST;
+  trajectory_marker.scale.x = 0.6;
+
+  // Points are red
+  trajectory_marker.color.r = 1.0f;
+  trajectory_marker.color.a = 1;
+  trajectory_marker.points.insert(trajectory_marker.points.end(),
+                                  debug_output.trajectory_points.begin(),
+                                  debug_output.trajectory_points.end());
+  unique_id++;
+  
+  // all candidates in one marker; each pair of points is a segment
+  visualization_msgs::Marker& debug_trajectories_marker = reuseMarker(points_marker_array, unique_id);
+  debug_trajectories_marker.lifetime = ros::Duration(0.2);
+  debug_trajectories_marker.header = debug_output.header;
+  debug_trajectories_marker.ns = std::string("debug_trajectory_marker");
+  debug_trajectories_marker.action = visualization_msgs::Marker::MODIFY;
+  debug_trajectories_marker.pose.orientation.w = 1.0;
+  debug_trajectories_marker.id = unique_id;
+  debug_trajectories_marker.type = visualization_msgs::Marker::LINE_LIST;
+  debug_trajectories_marker.scale.x = 0.1;
+  debug_trajectories_marker.color.r = 1.0f;
+  debug_trajectories_marker.color.a = 0.3;
+  for(const auto& trajectory: debug_output.debug_trajectories)
+  {
+    for(size_t i = 1; i < trajectory.waypoints.size(); i++)
     {
-      trajectory_count += 1;
-      visualization_msgs::Marker trajectory_marker;
-      trajectory_marker.lifetime = ros::Duration(0.2);
-      trajectory_marker.header = in_pose_ptr_->header;
-      // trajectory_marker.ns = std::string("debug_trajectory_marker");
-      trajectory_marker.ns = std::string("debug_trajectory_marker");
-      trajectory_marker.action = visualization_msgs::Marker::MODIFY;
-      trajectory_marker.pose.orientation.w = 1.0;
-      trajectory_marker.id = unique_id;
-      trajectory_marker.type = visualization_msgs::Marker::SPHERE_LIST;
-      trajectory_marker.scale.x = 0.5;
-
-      // Points are red
-      trajectory_marker.color.r = 1.0f;
-      trajectory_marker.color.a = 0.3;
-      for (const auto& waypoint: trajectory.waypoints)
-      {
-        geometry_msgs::Point geometry_point;
-        geometry_point.x = waypoint.pose.pose.position.x;
-        geometry_point.y = waypoint.pose.pose.position.y;
-        geometry_point.z = waypoint.pose.pose.position.z;
-        trajectory_marker.points.push_back(geometry_point);
-      }
-      points_marker_array.markers.push_back(trajectory_marker);
-      unique_id++; 
+      debug_trajectories_marker.points.push_back(trajectory.waypoints[i-1].pose.pose.position);
+      debug_trajectories_marker.points.push_back(trajectory.waypoints[i].pose.pose.position);
     }
-    
-    markers_pub_.publish(points_marker_array);
   }
+  unique_id++;
+  points_marker_array.markers.resize(unique_id);
+  
+  markers_pub_.publish(points_marker_array);
 }
 
 void FrenetPlannerROS::loadVectormap()
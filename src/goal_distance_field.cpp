@@ -0,0 +1,159 @@
+#include <cmath>
+#include <queue>
+#include <limits>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+#include "goal_distance_field.h"
+
+namespace
+{
+// octile distance is at most this ratio longer than the euclidean one
+const double OCTILE_TO_EUCLIDEAN_RATIO = 1.0824;
+}
+
+GoalDistanceField::GoalDistanceField(const int downsample, const double min_r):
+downsample_(std::max(1, downsample)),
+min_r_(min_r),
+rows_(0),
+cols_(0),
+coarse_resolution_(0),
+top_left_corner_(Eigen::Vector2d::Zero()),
+goal_p_(Eigen::Vector2d::Zero()),
+timestamp_(0),
+roi_key_(0),
+is_computed_(false),
+is_goal_on_map_(false),
+number_of_visited_cells_(0)
+{
+}
+
+GoalDistanceField::~GoalDistanceField()
+{
+}
+
+void GoalDistanceField::compute(const grid_map::Matrix& clearance_data,
+                                const grid_map::Position& map_position,
+                                const double resolution,
+                                const double clearance_to_m,
+                                const Eigen::Vector2d& goal_p,
+                                const grid_map::Time timestamp,
+                                const size_t roi_key)
+{
+  rows_ = (clearance_data.rows() + downsample_ - 1)/downsample_;
+  cols_ = (clearance_data.cols() + downsample_ - 1)/downsample_;
+  coarse_resolution_ = resolution*downsample_;
+  top_left_corner_ = map_position +
+                     0.5*resolution*Eigen::Vector2d(clearance_data.rows(), clearance_data.cols());
+  goal_p_ = goal_p;
+  timestamp_ = timestamp;
+  roi_key_ = roi_key;
+  is_computed_ = true;
+  number_of_visited_cells_ = 0;
+  
+  distance_.assign(rows_*cols_, std::numeric_limits<double>::infinity());
+  int goal_row, goal_col;
+  is_goal_on_map_ = getCoarseIndex(goal_p, goal_row, goal_col);
+  if(!is_goal_on_map_)
+  {
+    // kept as computed, so that it is not retried for the same goal and map;
+    // getHeuristic falls back to the euclidean distance
+    return;
+  }
+  
+  // the straight segment between a bubble and its child on the rim keeps clearance of half the child radius,
+  // so any cell of a searched path has at least min_r/2; optimistic downsampling keeps the field a lower bound
+  const float min_clearance = 0.5*min_r_/clearance_to_m;
+  std::vector<uint8_t> is_free(rows_*cols_, 0);
+  for(int col = 0; col < clearance_data.cols(); col++)
+  {
+    for(int row = 0; row < clearance_data.rows(); row++)
+    {
+      if(clearance_data(row, col) >= min_clearance)
+      {
+        is_free[row/downsample_ + (col/downsample_)*rows_] = 1;
+      }
+    }
+  }
+  
+  typedef std::pair<double, int> QueueElement;
+  std::priority_queue<QueueElement, std::vector<QueueElement>, std::greater<QueueElement>> open_queue;
+  const int goal_index = goal_row + goal_col*rows_;
+  distance_[goal_index] = 0;
+  open_queue.push(QueueElement(0, goal_index));
+  const double diagonal_step = coarse_resolution_*std::sqrt(2.0);
+  while(!open_queue.empty())
+  {
+    const QueueElement element = open_queue.top();
+    open_queue.pop();
+    const int index = element.second;
+    if(element.first > distance_[index])
+    {
+      continue;
+    }
+    number_of_visited_cells_++;
+    const int row = index % rows_;
+    const int col = index / rows_;
+    for(int d_col = -1; d_col <= 1; d_col++)
+    {
+      for(int d_row = -1; d_row <= 1; d_row++)
+      {
+        const int neighbor_row = row + d_row;
+        const int neighbor_col = col + d_col;
+        if((d_row == 0 && d_col == 0) ||
+           neighbor_row < 0 || neighbor_row >= rows_ ||
+           neighbor_col < 0 || neighbor_col >= cols_)
+        {
+          continue;
+        }
+        const int neighbor_index = neighbor_row + neighbor_col*rows_;
+        if(!is_free[neighbor_index])
+        {
+          continue;
+        }
+        const double distance = element.first + ((d_row != 0 && d_col != 0) ? diagonal_step : coarse_resolution_);
+        if(distance < distance_[neighbor_index])
+        {
+          distance_[neighbor_index] = distance;
+          open_queue.push(QueueElement(distance, neighbor_index));
+        }
+      }
+    }
+  }
+}
+
+bool GoalDistanceField::isComputedFor(const Eigen::Vector2d& goal_p,
+                                      const grid_map::Time timestamp,
+                                      const size_t roi_key) const
+{
+  return is_computed_ && timestamp == timestamp_ && roi_key == roi_key_ &&
+         (goal_p - goal_p_).norm() < coarse_resolution_;
+}
+
+double GoalDistanceField::getHeuristic(const Eigen::Vector2d& position) const
+{
+  const double euclidean_distance = (goal_p_ - position).norm();
+  int row, col;
+  if(!is_computed_ || !is_goal_on_map_ || !getCoarseIndex(position, row, col))
+  {
+    return euclidean_distance;
+  }
+  // the position and the goal may each be half a diagonal away from their cell centers
+  const double field_distance = distance_[row + col*rows_]/OCTILE_TO_EUCLIDEAN_RATIO -
+                                coarse_resolution_*std::sqrt(2.0);
+  return std::max(euclidean_distance, field_distance);
+}
+
+size_t GoalDistanceField::getNumberOfVisitedCells() const
+{
+  return number_of_visited_cells_;
+}
+
+bool GoalDistanceField::getCoarseIndex(const Eigen::Vector2d& position, int& row, int& col) const
+{
+  const Eigen::Vector2d coarse_position = (top_left_corner_ - position)/coarse_resolution_;
+  row = std::floor(coarse_position(0));
+  col = std::floor(coarse_position(1));
+  return row >= 0 && row < rows_ && col >= 0 && col < cols_;
+}
@@ -0,0 +1,50 @@
+#include <sstream>
+#include <algorithm>
+
+#include "latency_statistics.h"
+
+LatencyStatistics::LatencyStatistics(const std::string& name, const size_t report_interval):
+name_(name),
+report_interval_(report_interval)
+{
+  samples_.reserve(report_interval_);
+}
+
+LatencyStatistics::~LatencyStatistics()
+{
+}
+
+bool LatencyStatistics::add(const double latency_second)
+{
+  samples_.push_back(latency_second);
+  if(samples_.size() < report_interval_)
+  {
+    return false;
+  }
+  updateReport();
+  samples_.clear();
+  return true;
+}
+
+const std::string& LatencyStatistics::getReport() const
+{
+  return report_;
+}
+
+void LatencyStatistics::updateReport()
+{
+  std::sort(samples_.begin(), samples_.end());
+  auto percentile_milli_sec = [this](const double ratio)
+  {
+    const size_t index = std::min(samples_.size() - 1, static_cast<size_t>(ratio*samples_.size()));
+    return samples_[index]*1000.0;
+  };
+  std::ostringstream report;
+  report << name_
+         << " p50 " << percentile_milli_sec(0.5)
+         << " p90 " << percentile_milli_sec(0.9)
+         << " p99 " << percentile_milli_sec(0.99)
+         << " max " << samples_.back()*1000.0
+         << " milli sec over " << samples_.size() << " cycles";
+  report_ = report.str();
+}
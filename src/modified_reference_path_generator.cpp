@@ -1,38 +1,57 @@
 #include <memory>
+#include <algorithm>
+#include <limits>
 #include <autoware_msgs/Waypoint.h>
 
 #include <geometry_msgs/TransformStamped.h>
-#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+
+#include <ros/console.h>
 
 #include <grid_map_ros/GridMapRosConverter.hpp>
 #include <grid_map_ros/grid_map_ros.hpp>
 #include <grid_map_msgs/GridMap.h>
 
-#include <distance_transform/distance_transform.hpp>
-
 #include "modified_reference_path_generator.h"
-
-
-class Node
+#include "clearance_map_generator.h"
+#include "bubble_a_star.h"
+#include "goal_distance_field.h"
+#include "clearance_sampler.h"
+#include "tiled_clearance_grid.h"
+#include "elastic_band_smoother.h"
+#include "rigid_transform.h"
+
+namespace
 {
-public:
-  Node();
-  ~Node();
-  
-  Eigen::Vector2d p;
-  double r;
-  double g;
-  double h;
-  double f;
-  std::shared_ptr<Node> parent_node;
-};
-
-Node::Node()
+const int MAX_DEGREE_OF_B_SPLINE = 3;
+// metres
+const double B_SPLINE_MAX_SAMPLING_INTERVAL = 1.0;
+const double B_SPLINE_MAX_CHORD_ERROR = 0.02;
+const double ELASTIC_BAND_ANCHOR_WEIGHT = 0.5;
+const double ELASTIC_BAND_CONVERGENCE_DISTANCE = 0.001;
+const size_t CLEARANCE_ROI_KEY_PRIME = 1000003;
+
+// waypoints at 2D points in lidar frame, all at height z; points are columns
+void appendWaypointsInMapFrame(const Eigen::Matrix2Xd& points_in_lidar_tf,
+                               const double z,
+                               const RigidTransform& lidar2map_transform,
+                               std::vector<autoware_msgs::Waypoint>& waypoints)
 {
+  Eigen::Matrix3Xd points_in_map_tf;
+  lidar2map_transform.transformPoints(points_in_lidar_tf, z, points_in_map_tf);
+  geometry_msgs::Quaternion identity;
+  identity.w = 1.0;
+  const geometry_msgs::Quaternion orientation_in_map_tf = lidar2map_transform.transformOrientation(identity);
+  waypoints.reserve(waypoints.size() + points_in_map_tf.cols());
+  for(int i = 0; i < points_in_map_tf.cols(); i++)
+  {
+    autoware_msgs::Waypoint waypoint;
+    waypoint.pose.pose.position.x = points_in_map_tf(0, i);
+    waypoint.pose.pose.position.y = points_in_map_tf(1, i);
+    waypoint.pose.pose.position.z = points_in_map_tf(2, i);
+    waypoint.pose.pose.orientation = orientation_in_map_tf;
+    waypoints.push_back(waypoint);
+  }
 }
-
-Node::~Node()
-{
 }
 
 struct PathPoint
@@ -55,105 +74,42 @@ double calculate2DDistace(const Eigen::Vector2d& point1,
   return distance;
 }
 
-bool compareF(Node lhs, Node rhs) { return lhs.f < rhs.f; }
-
-std::vector<Node> expandNode(Node& parent_node, 
-                             const grid_map::GridMap& clearence_map,
-                             const Node& goal_node,
-                             const double min_r,
-                             const double max_r)
-{
-  // const double min_r = 1.6;
-  // const double max_r = 10;
-  
-  //r min max
-  double current_r;
-  if(parent_node.r < min_r)
-  {
-    current_r = min_r;
-  }
-  else if(parent_node.r > max_r)
-  {
-    current_r = max_r;
-  }
-  else
-  {
-    current_r = parent_node.r;
-  }
-  
-  
-  std::vector<Node> child_nodes;
-  Eigen::Vector2d delta_child_p;
-  delta_child_p << current_r,
-                   0;
-  double delta_theta = 2*M_PI/36.0;
-  for(double theta = 0; theta < 2*M_PI; theta += delta_theta)
-  {
-    // std::cerr << "theta " << theta << std::endl;
-    Eigen::Matrix2d rotation;
-    rotation << std::cos(theta), - std::sin(theta),
-                std::sin(theta),   std::cos(theta);
-    // std::cerr << "rotation " << rotation << std::endl;
-    Eigen::Vector2d rotated_delta = rotation * delta_child_p;
-    // std::cerr << "aaaaa " << rotated_delta << std::endl;
-    Node child_node;
-    child_node.p = rotated_delta + parent_node.p;
-    try 
-    {
-      double tmp_r = clearence_map.atPosition(clearence_map.getLayers().back(),
-                                             child_node.p)*0.1;
-      double r = std::min(tmp_r, max_r);
-      if(r < min_r)
-      {
-        continue;
-      }
-      child_node.r = r;
-    }
-    catch (const std::out_of_range& e) 
-    {
-      continue;
-    }
-    child_node.g = parent_node.g + current_r;
-    child_node.h = calculate2DDistace(child_node.p, goal_node.p);
-    child_node.f = child_node.g + child_node.h;
-    child_node.parent_node = std::make_shared<Node>(parent_node);
-    child_nodes.push_back(child_node);
-  }
-  return child_nodes;
-}
-
-bool isOverlap(Node node1, Node node2)
+ModifiedReferencePathGenerator::ModifiedReferencePathGenerator(
+  const double min_radius,
+  const size_t distance_transform_num_threads,
+  const bool use_incremental_clearance_map,
+  const bool use_clearance_roi,
+  const int goal_distance_heuristic_downsample,
+  const bool use_adaptive_branching,
+  const bool use_bilinear_clearance,
+  const bool use_tiled_clearance_grid,
+  const int elastic_band_max_iterations,
+  const bool use_receding_horizon):
+  min_radius_(min_radius),
+  use_incremental_clearance_map_(use_incremental_clearance_map),
+  use_clearance_roi_(use_clearance_roi),
+  use_adaptive_branching_(use_adaptive_branching),
+  clearance_interpolation_(use_bilinear_clearance ?
+                           ClearanceSampler::Interpolation::Bilinear :
+                           ClearanceSampler::Interpolation::Nearest),
+  clearance_map_generator_ptr_(new ClearanceMapGenerator(distance_transform_num_threads)),
+  use_receding_horizon_(use_receding_horizon)
 {
-  double distance = calculate2DDistace(node1.p, node2.p);
-  double max_r = std::max(node1.r, node2.r);
-  double min_r = std::min(node1.r, node2.r);
-  if((distance - max_r) < 0.5*min_r)
+  if(use_tiled_clearance_grid)
   {
-    return true;
+    tiled_clearance_grid_ptr_.reset(new TiledClearanceGrid());
   }
-  else
+  if(elastic_band_max_iterations > 0)
   {
-    return false;
+    elastic_band_smoother_ptr_.reset(
+      new ElasticBandSmoother(ELASTIC_BAND_ANCHOR_WEIGHT,
+                              elastic_band_max_iterations,
+                              ELASTIC_BAND_CONVERGENCE_DISTANCE));
   }
-}
-
-bool nodeExistInClosedNodes(Node node, std::vector<Node> closed_nodes)
-{
-  for(const auto& closed_node: closed_nodes)
+  if(goal_distance_heuristic_downsample > 0)
   {
-    double distance = calculate2DDistace(node.p, closed_node.p);
-    if(distance < closed_node.r)
-    {
-      return true;
-    }
+    goal_distance_field_ptr_.reset(new GoalDistanceField(goal_distance_heuristic_downsample, min_radius));
   }
-  return false;
-}
-
-ModifiedReferencePathGenerator::ModifiedReferencePathGenerator(
-  const double min_radius):
-  min_radius_(min_radius)
-{
 }
 
 ModifiedReferencePathGenerator::~ModifiedReferencePathGenerator()
@@ -270,7 +226,7 @@ Eigen::Vector2d ModifiedReferencePathGenerator::generateNewPosition(
           const Eigen::Vector2d& path_point1,
           const Eigen::Vector2d& path_point2,
           const Eigen::Vector2d& path_point3,
-          const grid_map::GridMap& clearance_map,
+          const ClearanceSampler& clearance_sampler,
           const double min_r,
           const double max_k,
           const double resolustion_of_gridmap)
@@ -316,33 +272,26 @@ Eigen::Vector2d ModifiedReferencePathGenerator::generateNewPosition(
   }
   e << ex, ey;
   
-  double result_r;
   do
   {
     double k = calculateCurvatureFromThreePoints(parent_of_path_point1,
                                       path_point1,
                                       e);
-    try 
-    {
-      double r = clearance_map.atPosition(clearance_map.getLayers().back(),
-                                              e)*0.1;
-      if(r > min_r && k < max_k)
-      {
-        return e;
-      }
-      else
-      {
-        e = (e + path_point2)/2;
-      }
-      
-    }
-    catch (const std::out_of_range& error) 
+    double r;
+    if(!clearance_sampler.sample(e, r))
     {
       std::cerr << "e " << e << std::endl;
       std::cerr << "WARNING: could not find clearance in generateNewPostion " << std::endl;
       return path_point2;
     }
-    result_r = clearance_map.atPosition(clearance_map.getLayers().back(),e)*0.1;
+    if(r > min_r && k < max_k)
+    {
+      return e;
+    }
+    else
+    {
+      e = (e + path_point2)/2;
+    }
   }while(calculate2DDistace(e, path_point2) > 0.1);
   return path_point2;
 }
@@ -379,135 +328,250 @@ std::vector<double>  ModifiedReferencePathGenerator::generateOpenUniformKnotVect
 }
 
 
-double ModifiedReferencePathGenerator::calaculateBasisFunction(
+size_t ModifiedReferencePathGenerator::findKnotSpan(
      const std::vector<double>& knot_vector,
-     const size_t control_point_index,
-     const size_t basis_function_index,
+     const int degree_of_b_spline,
+     const size_t number_of_control_points,
      const double function_value)
 {
-  double value = 0;
-  if(basis_function_index == 0)
+  // knot_vector[span] <= function_value < knot_vector[span+1]; the last span also takes the end value
+  const size_t span = std::upper_bound(knot_vector.begin(), knot_vector.end(), function_value) -
+                      knot_vector.begin() - 1;
+  return std::min(std::max(span, static_cast<size_t>(degree_of_b_spline)), number_of_control_points - 1);
+}
+
+Eigen::Vector2d ModifiedReferencePathGenerator::evaluateBSpline(
+     const std::vector<PathPoint>& control_points,
+     const std::vector<double>& knot_vector,
+     const int degree_of_b_spline,
+     const size_t knot_span,
+     const double function_value)
+{
+  // de Boor; only the degree+1 control points of the span contribute
+  Eigen::Vector2d d[MAX_DEGREE_OF_B_SPLINE + 1];
+  for(int j = 0; j <= degree_of_b_spline; j++)
   {
-    if(function_value > knot_vector[control_point_index] &&
-       function_value <= knot_vector[control_point_index+1])
+    d[j] = control_points[j + knot_span - degree_of_b_spline].position;
+  }
+  for(int r = 1; r <= degree_of_b_spline; r++)
+  {
+    for(int j = degree_of_b_spline; j >= r; j--)
     {
-      value = 1.0;
+      const double left_knot = knot_vector[j + knot_span - degree_of_b_spline];
+      const double right_knot = knot_vector[j + 1 + knot_span - r];
+      const double alpha = (right_knot == left_knot) ? 0 : (function_value - left_knot)/(right_knot - left_knot);
+      d[j] = (1 - alpha)*d[j-1] + alpha*d[j];
     }
-    else
+  }
+  return d[degree_of_b_spline];
+}
+
+void ModifiedReferencePathGenerator::keepValidBubblePrefix(
+  const Eigen::Vector2d& start_p,
+  const double start_r,
+  const BubbleNode& goal_node,
+  const double max_r,
+  const BubbleAStar::ClearanceFunction& clearance_function,
+  const RigidTransform& map2lidar_transform,
+  std::vector<BubbleNode>& kept_bubbles)
+{
+  kept_bubbles.clear();
+  if(previous_bubble_path_.empty())
+  {
+    return;
+  }
+  
+  Eigen::Matrix2Xd previous_positions_in_map_tf(2, previous_bubble_path_.size());
+  for(size_t i = 0; i < previous_bubble_path_.size(); i++)
+  {
+    previous_positions_in_map_tf.col(i) = previous_bubble_path_[i].head<2>();
+  }
+  Eigen::Matrix3Xd previous_positions_in_lidar_tf;
+  map2lidar_transform.transformPoints(previous_positions_in_map_tf, 0, previous_positions_in_lidar_tf);
+  std::vector<Eigen::Vector2d> previous_positions;
+  previous_positions.reserve(previous_bubble_path_.size());
+  for(int i = 0; i < previous_positions_in_lidar_tf.cols(); i++)
+  {
+    previous_positions.push_back(previous_positions_in_lidar_tf.col(i).head<2>());
+  }
+  
+  //bubbles up to the nearest one have been passed
+  size_t nearest_index = 0;
+  double min_distance = std::numeric_limits<double>::max();
+  for(size_t i = 0; i < previous_positions.size(); i++)
+  {
+    const double distance = calculate2DDistace(previous_positions[i], start_p);
+    if(distance < min_distance)
     {
-      value = 0.0;
+      min_distance = distance;
+      nearest_index = i;
     }
   }
-  else
+  
+  Eigen::Vector2d parent_p = start_p;
+  double parent_r = start_r;
+  for(size_t i = nearest_index + 1; i < previous_positions.size(); i++)
   {
-    double w1 = 0;
-    double w2 = 0;
-    if((knot_vector[control_point_index+basis_function_index+1] - 
-        (knot_vector[control_point_index + 1])) != 0)
-    {
-      w1 = calaculateBasisFunction(knot_vector, 
-                                  control_point_index+1, 
-                                  basis_function_index - 1, 
-                                  function_value)*
-           (knot_vector[control_point_index+basis_function_index+1] - function_value)/
-           (knot_vector[control_point_index+basis_function_index+1] - 
-            knot_vector[control_point_index+1]); 
+    // clearance may have changed since the previous path was searched
+    double r = 0;
+    if(!clearance_function(previous_positions[i], r))
+    {
+      break;
     }
-    if((knot_vector[control_point_index+basis_function_index] - 
-       knot_vector[control_point_index]) != 0)
-    {
-      w2 = calaculateBasisFunction(knot_vector, 
-                                  control_point_index, 
-                                  basis_function_index - 1, 
-                                  function_value)*
-           (function_value - knot_vector[control_point_index])/
-           (knot_vector[control_point_index+basis_function_index] -
-            knot_vector[control_point_index]); 
+    r = std::min(r, max_r);
+    if(r < min_radius_ ||
+       calculate2DDistace(previous_positions[i], parent_p) > std::max(r, parent_r))
+    {
+      break;
     }
-    value = w1 + w2;
+    BubbleNode node;
+    node.p = previous_positions[i];
+    node.r = r;
+    node.g = 0;
+    node.h = 0;
+    node.f = 0;
+    node.parent_index = -1;
+    kept_bubbles.push_back(node);
+    if(BubbleAStar::isOverlap(node, goal_node))
+    {
+      break;
+    }
+    parent_p = node.p;
+    parent_r = node.r;
+  }
+}
+
+void ModifiedReferencePathGenerator::storeBubblePath(
+  const std::vector<BubbleNode>& bubble_path,
+  const RigidTransform& lidar2map_transform)
+{
+  Eigen::Matrix2Xd positions_in_lidar_tf(2, bubble_path.size());
+  for(size_t i = 0; i < bubble_path.size(); i++)
+  {
+    positions_in_lidar_tf.col(i) = bubble_path[i].p;
+  }
+  Eigen::Matrix3Xd positions_in_map_tf;
+  lidar2map_transform.transformPoints(positions_in_lidar_tf, 0, positions_in_map_tf);
+  previous_bubble_path_.clear();
+  previous_bubble_path_.reserve(bubble_path.size());
+  for(size_t i = 0; i < bubble_path.size(); i++)
+  {
+    previous_bubble_path_.push_back(Eigen::Vector3d(positions_in_map_tf(0, i),
+                                                    positions_in_map_tf(1, i),
+                                                    bubble_path[i].r));
   }
-  return value;
+}
+
+bool ModifiedReferencePathGenerator::canReuseClearanceMap() const
+{
+  // clearance out of the corridor is saturated when only the region of interest is computed
+  return use_incremental_clearance_map_ || !use_clearance_roi_;
 }
 
 bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
     grid_map::GridMap& clearance_map, 
+    const bool reuse_clearance_map,
     const geometry_msgs::Point& start_point, 
     const geometry_msgs::Point& goal_point,
+    const std::vector<geometry_msgs::Point>& reference_points,
     const geometry_msgs::TransformStamped& lidar2map_tf, 
     const geometry_msgs::TransformStamped& map2lidar_tf,
     std::vector<autoware_msgs::Waypoint>& modified_reference_path,
     std::vector<autoware_msgs::Waypoint>& debug_a_star_path,
     std::vector<autoware_msgs::Waypoint>& debug_modified_smoothed_reference_path,
     std::vector<autoware_msgs::Waypoint>& debug_bspline_path,
-    sensor_msgs::PointCloud2& debug_pointcloud_clearance_map)
+    sensor_msgs::PointCloud2* debug_pointcloud_clearance_map)
 {
   std::string layer_name = clearance_map.getLayers().back();
-  grid_map::Matrix data = clearance_map.get(layer_name);
-
-  // grid_length y and grid_length_x respectively
-  dope::Index2 size({ 200, 600 });
-  dope::Grid<float, 2> f(size);
-  dope::Grid<dope::SizeType, 2> indices(size);
-  bool is_empty_cost = true;
-  for (dope::SizeType i = 0; i < size[0]; ++i)
+  // distance transform works on the raw storage, so it has to start at index (0, 0)
+  if(!clearance_map.isDefaultStartIndex())
   {
-    for (dope::SizeType j = 0; j < size[1]; ++j)
-    {
-      if (data(i * size[1] + j) > 0.01)
-      {
-        f[i][j] = 0.0f;
-        is_empty_cost = false;
-      }
-      else
-      {
-        f[i][j] = std::numeric_limits<float>::max();
-      }
-    }
+    clearance_map.convertToDefaultStartIndex();
   }
-
-  // Note: this is necessary at least at the first distance transform execution
-  // and every time a reset is desired; it is not, instead, when updating
-  dt::DistanceTransform::initializeIndices(indices);
-  dt::DistanceTransform::distanceTransformL2(f, f, false, 1);
-
-  for (dope::SizeType i = 0; i < size[0]; ++i)
+  grid_map::Matrix& data = clearance_map.get(layer_name);
+  
+  const RigidTransform lidar2map_transform(lidar2map_tf);
+  const RigidTransform map2lidar_transform(map2lidar_tf);
+  const geometry_msgs::Point start_point_in_lidar_tf = map2lidar_transform.transformPoint(start_point);
+  const geometry_msgs::Point goal_point_in_lidar_tf = map2lidar_transform.transformPoint(goal_point);
+  
+  Eigen::Vector2d start_p, goal_p;
+  start_p(0) = start_point_in_lidar_tf.x; 
+  start_p(1) = start_point_in_lidar_tf.y; 
+  goal_p(0) = goal_point_in_lidar_tf.x; 
+  goal_p(1) = goal_point_in_lidar_tf.y; 
+  
+  const double max_r = 10;
+  // identifies the corridor the clearance is computed in; 0 for the whole map
+  size_t clearance_roi_key = 0;
+  if(reuse_clearance_map)
+  {
+    // clearance of the previous costmap is still valid
+  }
+  else if(use_incremental_clearance_map_)
   {
-    for (dope::SizeType j = 0; j < size[1]; ++j)
+    clearance_map_generator_ptr_->updateClearanceMap(data,
+                                                     clearance_map.getPosition(),
+                                                     clearance_map.getResolution());
+  }
+  else if(use_clearance_roi_)
+  {
+    // bubbles are searched in the corridor of max_r around the reference path from start to goal;
+    // clearance outside of it is 0, so that the search does not leave the corridor
+    Eigen::Matrix2Xd corridor_points_in_lidar_tf(2, reference_points.size() + 2);
+    corridor_points_in_lidar_tf.col(0) = start_p;
+    if(!reference_points.empty())
     {
-      if (is_empty_cost)
-      {
-        data(i * size[1] + j) = 1;
-      }
-      else
+      Eigen::Matrix3Xd reference_points_in_map_tf(3, reference_points.size());
+      for(size_t i = 0; i < reference_points.size(); i++)
       {
-        data(i * size[1] + j) = f[i][j];
+        reference_points_in_map_tf.col(i) << reference_points[i].x, reference_points[i].y, reference_points[i].z;
       }
+      Eigen::Matrix3Xd reference_points_in_lidar_tf;
+      map2lidar_transform.transformPoints(reference_points_in_map_tf, reference_points_in_lidar_tf);
+      corridor_points_in_lidar_tf.middleCols(1, reference_points.size()) = reference_points_in_lidar_tf.topRows(2);
+    }
+    corridor_points_in_lidar_tf.rightCols(1) = goal_p;
+    
+    const double resolution = clearance_map.getResolution();
+    // index (0, 0) is the corner of max x and max y; indices grow as x and y decrease
+    const grid_map::Position top_left_corner = clearance_map.getPosition() + clearance_map.getLength().matrix()/2;
+    std::vector<grid_map::Index> corridor_indices;
+    corridor_indices.reserve(corridor_points_in_lidar_tf.cols());
+    for(int i = 0; i < corridor_points_in_lidar_tf.cols(); i++)
+    {
+      const Eigen::Vector2d index = ((top_left_corner - corridor_points_in_lidar_tf.col(i))/resolution).array().floor();
+      corridor_indices.push_back(index.cast<int>().array());
+      clearance_roi_key = clearance_roi_key*CLEARANCE_ROI_KEY_PRIME + corridor_indices.back()(0);
+      clearance_roi_key = clearance_roi_key*CLEARANCE_ROI_KEY_PRIME + corridor_indices.back()(1);
     }
+    clearance_map_generator_ptr_->generateClearanceMap(data,
+                                                       corridor_indices,
+                                                       max_r/resolution,
+                                                       std::ceil(max_r/resolution),
+                                                       0);
+  }
+  else
+  {
+    clearance_map_generator_ptr_->generateClearanceMap(data);
   }
 
-  clearance_map[layer_name] = data;
-  grid_map::GridMapRosConverter::toPointCloud(clearance_map, layer_name, debug_pointcloud_clearance_map);
-
-  geometry_msgs::Point start_point_in_lidar_tf, goal_point_in_lidar_tf;
-  tf2::doTransform(start_point, start_point_in_lidar_tf, map2lidar_tf);
-  tf2::doTransform(goal_point, goal_point_in_lidar_tf, map2lidar_tf);
-  
-  Eigen::Vector2d start_p, goal_p;
-  start_p(0) = start_point_in_lidar_tf.x; 
-  start_p(1) = start_point_in_lidar_tf.y; 
-  goal_p(0) = goal_point_in_lidar_tf.x; 
-  goal_p(1) = goal_point_in_lidar_tf.y; 
+  if(debug_pointcloud_clearance_map)
+  {
+    grid_map::GridMapRosConverter::toPointCloud(clearance_map, layer_name, *debug_pointcloud_clearance_map);
+  }
   
-  // std::cerr << "initial start p " << start_p << std::endl;
-  std::vector<Node> s_open;
-  Node* a = new Node();
-  Node initial_node;
-  double clearance_to_m = 0.1;
+  // distance transform is in cells
+  const double clearance_to_m = clearance_map.getResolution();
+  const ClearanceSampler clearance_sampler(data,
+                                           clearance_map.getPosition(),
+                                           clearance_map.getResolution(),
+                                           clearance_to_m,
+                                           clearance_interpolation_);
   // const double min_r = 1.6;
   // const double min_r = 2.0;
-  const double max_r = 10;
-  initial_node.p = start_p;
-  double initial_r = clearance_map.atPosition(layer_name, initial_node.p) * clearance_to_m ;
+  double initial_r = 0;
+  clearance_sampler.sample(start_p, initial_r);
   if(initial_r < min_radius_)
   {
     initial_r = min_radius_;
@@ -516,16 +580,9 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
   {
     initial_r = max_r;
   }
-  initial_node.r = initial_r;
-  initial_node.g = 0;
-  initial_node.h = calculate2DDistace(initial_node.p, goal_p);
-  initial_node.f = initial_node.g + initial_node.h;
-  initial_node.parent_node = nullptr;
-  s_open.push_back(initial_node);
   
-  Node goal_node;
-  goal_node.p = goal_p;
-  double goal_r = clearance_map.atPosition(layer_name, goal_node.p) * clearance_to_m ;
+  double goal_r = 0;
+  clearance_sampler.sample(goal_p, goal_r);
   if(goal_r < min_radius_)
   {
     goal_r = min_radius_;
@@ -534,82 +591,144 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
   {
     goal_r = max_r;
   }
+  
+  BubbleAStar::ClearanceFunction clearance_function;
+  if(tiled_clearance_grid_ptr_)
+  {
+    if(!reuse_clearance_map)
+    {
+      tiled_clearance_grid_ptr_->build(data, clearance_map.getPosition(), clearance_map.getResolution(), clearance_to_m);
+    }
+    const TiledClearanceGrid& tiled_clearance_grid = *tiled_clearance_grid_ptr_;
+    clearance_function = [&tiled_clearance_grid](const Eigen::Vector2d& position, double& clearance)
+    {
+      return tiled_clearance_grid.sample(position, clearance);
+    };
+  }
+  else
+  {
+    clearance_function = [&clearance_sampler](const Eigen::Vector2d& position, double& clearance)
+    {
+      return clearance_sampler.sample(position, clearance);
+    };
+  }
+  
+  BubbleAStar::HeuristicFunction heuristic_function;
+  if(goal_distance_field_ptr_)
+  {
+    if(!goal_distance_field_ptr_->isComputedFor(goal_p, clearance_map.getTimestamp(), clearance_roi_key))
+    {
+      goal_distance_field_ptr_->compute(data,
+                                        clearance_map.getPosition(),
+                                        clearance_map.getResolution(),
+                                        clearance_to_m,
+                                        goal_p,
+                                        clearance_map.getTimestamp(),
+                                        clearance_roi_key);
+      ROS_DEBUG("goal distance field visited cells %zu", goal_distance_field_ptr_->getNumberOfVisitedCells());
+    }
+    const GoalDistanceField& goal_distance_field = *goal_distance_field_ptr_;
+    heuristic_function = [&goal_distance_field](const Eigen::Vector2d& position)
+    {
+      return goal_distance_field.getHeuristic(position);
+    };
+  }
+  
+  BubbleNode goal_node;
+  goal_node.p = goal_p;
   goal_node.r = goal_r;
-  goal_node.g = 0;
-  goal_node.h = 0;
-  goal_node.f = 0;
   
-  double f_goal = std::numeric_limits<double>::max();
+  // receding horizon: keep the part of the previous bubble path which is still free,
+  // and only search from its end to the goal
+  std::vector<BubbleNode> kept_bubbles;
+  if(use_receding_horizon_)
+  {
+    keepValidBubblePrefix(start_p, initial_r, goal_node, max_r, clearance_function, map2lidar_transform, kept_bubbles);
+  }
   
-  std::vector<Node> s_closed;
-  while(!s_open.empty())
+  std::vector<BubbleNode> searched_bubbles;
+  bool is_searched = false;
+  if(kept_bubbles.empty() || !BubbleAStar::isOverlap(kept_bubbles.back(), goal_node))
   {
-    std::sort(s_open.begin(), s_open.end(), compareF);
-    Node lowest_f_node = s_open.front();
-    s_open.erase(s_open.begin());
-    if(f_goal < lowest_f_node.f)
+    const Eigen::Vector2d search_start_p = kept_bubbles.empty() ? start_p : kept_bubbles.back().p;
+    const double search_start_r = kept_bubbles.empty() ? initial_r : kept_bubbles.back().r;
+    BubbleAStar bubble_a_star(min_radius_, max_r, use_adaptive_branching_);
+    bubble_a_star.search(search_start_p, search_start_r, goal_p, goal_r, clearance_function, heuristic_function);
+    if(!kept_bubbles.empty() &&
+       calculate2DDistace(bubble_a_star.getNodes()[bubble_a_star.getLastNodeIndex()].p, goal_p) > 5)
     {
-      break;
+      // repair failed; start over from the vehicle
+      ROS_WARN_THROTTLE(1.0, "could not repair modified reference path; searching from start point");
+      kept_bubbles.clear();
+      bubble_a_star.search(start_p, initial_r, goal_p, goal_r, clearance_function, heuristic_function);
     }
-    else if(nodeExistInClosedNodes(lowest_f_node, s_closed))
+    is_searched = true;
+    const std::vector<BubbleNode>& nodes = bubble_a_star.getNodes();
+    const BubbleAStarStatistics& a_star_statistics = bubble_a_star.getStatistics();
+    ROS_DEBUG("a star expansions %zu generated nodes %zu skipped nodes %zu pruned children %zu %.3f milli sec",
+              a_star_statistics.number_of_expansions,
+              a_star_statistics.number_of_generated_nodes,
+              a_star_statistics.number_of_skipped_nodes,
+              a_star_statistics.number_of_pruned_children,
+              a_star_statistics.elapsed_second*1000.0);
+  
+    //debugs
+    const std::vector<int>& closed_node_indices = bubble_a_star.getClosedNodeIndices();
+    Eigen::Matrix2Xd closed_points_in_lidar_tf(2, closed_node_indices.size());
+    for(size_t i = 0; i < closed_node_indices.size(); i++)
     {
-      continue;
+      closed_points_in_lidar_tf.col(i) = nodes[closed_node_indices[i]].p;
     }
-    else
+    const size_t debug_a_star_path_offset = debug_a_star_path.size();
+    appendWaypointsInMapFrame(closed_points_in_lidar_tf,
+                              start_point_in_lidar_tf.z,
+                              lidar2map_transform,
+                              debug_a_star_path);
+    for(size_t i = 0; i < closed_node_indices.size(); i++)
     {
-      std::vector<Node> child_nodes = 
-          expandNode(lowest_f_node, 
-                     clearance_map,
-                     goal_node,
-                     min_radius_,
-                     max_r);
-      s_open.insert(s_open.end(),
-                    child_nodes.begin(),
-                    child_nodes.end());
-      s_closed.push_back(lowest_f_node);
-      if(isOverlap(lowest_f_node, goal_node))
-      {
-        f_goal = lowest_f_node.f;
-      }
+      double r = 0;
+      clearance_sampler.sample(nodes[closed_node_indices[i]].p, r);
+      debug_a_star_path[debug_a_star_path_offset + i].cost = r;
     }
-  }
   
-  for(auto& point: s_closed)
-  { 
-    //debugs
-    geometry_msgs::Pose pose_in_lidar_tf;      
-    pose_in_lidar_tf.position.x = point.p(0);
-    pose_in_lidar_tf.position.y = point.p(1);
-    pose_in_lidar_tf.position.z = start_point_in_lidar_tf.z;
-    pose_in_lidar_tf.orientation.w = 1.0;
-    geometry_msgs::Pose pose_in_map_tf;
-    tf2::doTransform(pose_in_lidar_tf, pose_in_map_tf, lidar2map_tf);
-    autoware_msgs::Waypoint waypoint;
-    waypoint.pose.pose = pose_in_map_tf;
-    double r = clearance_map.atPosition(layer_name, point.p) * clearance_to_m ;
-    waypoint.cost = r;
-    debug_a_star_path.push_back(waypoint);
+    const int last_node_index = bubble_a_star.getLastNodeIndex();
+    if(calculate2DDistace(nodes[last_node_index].p, goal_p)>5)
+    {
+      std::cerr << "Error: could not fing modified global path; "  << std::endl; 
+      return false;
+    }
+    
+    //backtrack; the search start node is either the start point or the last kept bubble
+    for(int node_index = last_node_index;
+        nodes[node_index].parent_index >= 0;
+        node_index = nodes[node_index].parent_index)
+    {
+      searched_bubbles.push_back(nodes[node_index]);
+    }
+    std::reverse(searched_bubbles.begin(), searched_bubbles.end());
   }
   
-  if(calculate2DDistace(s_closed.back().p, goal_p)>5)
+  std::vector<BubbleNode> bubble_path = kept_bubbles;
+  bubble_path.insert(bubble_path.end(), searched_bubbles.begin(), searched_bubbles.end());
+  if(use_receding_horizon_)
   {
-    std::cerr << "Error: could not fing modified global path; "  << std::endl; 
-    return false;
+    ROS_DEBUG("receding horizon kept bubbles %zu searched bubbles %zu%s",
+              kept_bubbles.size(),
+              searched_bubbles.size(),
+              is_searched ? "" : " (no search)");
+    storeBubblePath(bubble_path, lidar2map_transform);
   }
   
   std::vector<PathPoint> path_points;
   
-  // autoware_msgs::Waypoint start_waypoint;
-  // start_waypoint.pose.pose.position = start_point;
-  // start_waypoint.pose.pose.orientation.w = 1.0;
-  // modified_reference_path.push_back(start_waypoint);
   PathPoint start_path_point;
   start_path_point.position = start_p;
-  try 
+  // min_radius_ pins the point in the elastic band when its clearance cannot be sampled
+  start_path_point.clearance = min_radius_;
+  double start_clearance;
+  if(clearance_sampler.sample(start_p, start_clearance))
   {
-    double tmp_r = clearance_map.atPosition(clearance_map.getLayers().back(),
-                                            start_p)*0.1;
-    double r = std::min(tmp_r, max_r);
+    double r = std::min(start_clearance, max_r);
     if(r < min_radius_)
     {
       r = min_radius_;
@@ -617,38 +736,20 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
     }
     start_path_point.clearance = r;
   }
-  catch (const std::out_of_range& e) 
+  else
   {
     std::cerr << "WARNING: could not find clearance for start point " << std::endl;
   }
   start_path_point.curvature = 0;
   path_points.push_back(start_path_point);
-  // std::cerr << "start p " << start_path_point.position << std::endl;
-  
-  //backtrack
-  Node current_node = s_closed.back();
-  while(current_node.parent_node != nullptr)
-  {
-    // geometry_msgs::Pose pose_in_lidar_tf;
-    // pose_in_lidar_tf.position.x = current_node.p(0);
-    // pose_in_lidar_tf.position.y = current_node.p(1);
-    // pose_in_lidar_tf.position.z = start_point_in_lidar_tf.z;
-    // pose_in_lidar_tf.orientation.w = 1.0;
-    // geometry_msgs::Pose pose_in_map_tf;
-    // tf2::doTransform(pose_in_lidar_tf, pose_in_map_tf, lidar2map_tf);
-    // autoware_msgs::Waypoint waypoint;
-    // waypoint.pose.pose = pose_in_map_tf;
-    // modified_reference_path.push_back(waypoint);
-    
+  
+  for(const auto& bubble: bubble_path)
+  {
     PathPoint path_point;
-    path_point.position = current_node.p;
-    path_point.clearance = current_node.r;
+    path_point.position = bubble.p;
+    path_point.clearance = bubble.r;
     path_point.curvature = 0;
-    // path_points.push_back(path_point);
-    path_points.insert(path_points.begin() + 1, path_point);
-    
-    current_node = *current_node.parent_node;
-    
+    path_points.push_back(path_point);
   }
   
   // for(const auto& point: path_points)
@@ -669,18 +770,18 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
   
   PathPoint goal_path_point;
   goal_path_point.position = goal_p;
-  try 
+  goal_path_point.clearance = min_radius_;
+  double goal_clearance;
+  if(clearance_sampler.sample(goal_p, goal_clearance))
   {
-    double tmp_r = clearance_map.atPosition(clearance_map.getLayers().back(),
-                                            goal_p)*0.1;
-    double r = std::min(tmp_r, max_r);
+    double r = std::min(goal_clearance, max_r);
     if(r < min_radius_)
     {
       r = min_radius_;
     }
     goal_path_point.clearance = r;
   }
-  catch (const std::out_of_range& e) 
+  else
   {
     std::cerr << "WARNING: could not find clearance for goal point " << std::endl;
   }
@@ -693,89 +794,106 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
   
   std::vector<PathPoint> refined_path = path_points;
   
-  double new_j, prev_j;
-  do
+  if(elastic_band_smoother_ptr_)
   {
-    // std::cerr << "------------" << std::endl;
-    prev_j = calculateSmoothness(refined_path);
-    
-    if(refined_path.size() < 3)
+    // each point may move as far as keeps min_radius_ of clearance from its bubble
+    std::vector<Eigen::Vector2d> centers;
+    std::vector<double> bound_radii;
+    for(const auto& path_point: path_points)
     {
-      std::cerr << "ERROR:somethign wrong"  << std::endl;
+      centers.push_back(path_point.position);
+      bound_radii.push_back(path_point.clearance - min_radius_);
     }
-    std::vector<PathPoint> new_refined_path;
-    new_refined_path.push_back(refined_path.front());
-    new_refined_path.push_back(refined_path[1]);
-    for(size_t i = 2; i < (refined_path.size()- 1); i++)
-    {
-      const double min_turning_radius = 5;
-      const double max_k = 1/min_turning_radius;
-      const double resolution_of_gridmap = clearance_map.getResolution();
-      double rs = clearance_map.atPosition(clearance_map.getLayers().back(),
-                                              refined_path[i].position)*0.1;
-      // std::cerr << "target clearance " << rs << std::endl;
-      Eigen::Vector2d new_position = 
-               generateNewPosition(refined_path[i - 2].position,
-                                refined_path[i - 1].position,
-                                refined_path[i].position,
-                                refined_path[i+1].position,
-                                clearance_map,
-                                min_radius_,
-                                max_k,
-                                resolution_of_gridmap);
-      double clearance;
-      try 
+    std::vector<Eigen::Vector2d> smoothed_points;
+    elastic_band_smoother_ptr_->smooth(centers, bound_radii, smoothed_points);
+    const ElasticBandStatistics& elastic_band_statistics = elastic_band_smoother_ptr_->getStatistics();
+    ROS_DEBUG("elastic band iterations %zu converged %d %.3f milli sec",
+              elastic_band_statistics.number_of_iterations,
+              static_cast<int>(elastic_band_statistics.is_converged),
+              elastic_band_statistics.elapsed_second*1000.0);
+    for(size_t i = 0; i < refined_path.size(); i++)
+    {
+      refined_path[i].position = smoothed_points[i];
+      clearance_sampler.sample(smoothed_points[i], refined_path[i].clearance);
+    }
+    calculateCurvatureForPathPoints(refined_path);
+  }
+  else
+  {
+    double new_j, prev_j;
+    do
+    {
+      // std::cerr << "------------" << std::endl;
+      prev_j = calculateSmoothness(refined_path);
+    
+      if(refined_path.size() < 3)
       {
-        clearance = clearance_map.atPosition(clearance_map.getLayers().back(),
-                                             refined_path[i].position)*0.1;
+        std::cerr << "ERROR:somethign wrong"  << std::endl;
       }
-      catch (const std::out_of_range& e) 
+      std::vector<PathPoint> new_refined_path;
+      new_refined_path.push_back(refined_path.front());
+      new_refined_path.push_back(refined_path[1]);
+      for(size_t i = 2; i < (refined_path.size()- 1); i++)
       {
-        std::cerr << "WARNING: could not find clearance for goal point " << std::endl;
+        const double min_turning_radius = 5;
+        const double max_k = 1/min_turning_radius;
+        const double resolution_of_gridmap = clearance_map.getResolution();
+        Eigen::Vector2d new_position = 
+                 generateNewPosition(refined_path[i - 2].position,
+                                  refined_path[i - 1].position,
+                                  refined_path[i].position,
+                                  refined_path[i+1].position,
+                                  clearance_sampler,
+                                  min_radius_,
+                                  max_k,
+                                  resolution_of_gridmap);
+        double clearance = 0;
+        if(!clearance_sampler.sample(refined_path[i].position, clearance))
+        {
+          std::cerr << "WARNING: could not find clearance for goal point " << std::endl;
+        }
+        double curvature = calculateCurvatureFromThreePoints(
+                                 refined_path[i-1].position,
+                                 refined_path[i].position,
+                                 refined_path[i+1].position);
+        PathPoint new_path_point;
+        new_path_point.position = new_position;
+        new_path_point.clearance = clearance;
+        new_path_point.curvature = curvature;
+        new_refined_path.push_back(new_path_point);
       }
-      double curvature = calculateCurvatureFromThreePoints(
-                               refined_path[i-1].position,
-                               refined_path[i].position,
-                               refined_path[i+1].position);
-      PathPoint new_path_point;
-      new_path_point.position = new_position;
-      new_path_point.clearance = clearance;
-      new_path_point.curvature = curvature;
-      new_refined_path.push_back(new_path_point);
-    }
-    new_refined_path.push_back(refined_path.back());
-    new_j = calculateSmoothness(new_refined_path);
+      new_refined_path.push_back(refined_path.back());
+      new_j = calculateSmoothness(new_refined_path);
     
-    double delta_j = std::abs(new_j - prev_j)/new_j;
-    // std::cerr << "prev j " << prev_j << std::endl;
-    // std::cerr << "new j " << new_j << std::endl;
-    // std::cerr << "delta j" << delta_j << std::endl;
-    if(new_j < prev_j)
-    {
-      refined_path = new_refined_path;
-      if(delta_j < 0.001)
+      double delta_j = std::abs(new_j - prev_j)/new_j;
+      // std::cerr << "prev j " << prev_j << std::endl;
+      // std::cerr << "new j " << new_j << std::endl;
+      // std::cerr << "delta j" << delta_j << std::endl;
+      if(new_j < prev_j)
       {
-        std::cerr << "break!" << std::endl;
-        break;  
+        refined_path = new_refined_path;
+        if(delta_j < 0.001)
+        {
+          std::cerr << "break!" << std::endl;
+          break;  
+        }
       }
-    }
-  } while (new_j < prev_j);
+    } while (new_j < prev_j);
+  }
   
-  for(const auto& point: refined_path)
+  Eigen::Matrix2Xd refined_points_in_lidar_tf(2, refined_path.size());
+  for(size_t i = 0; i < refined_path.size(); i++)
   {
-    // std::cerr << "poitn " << point.position(0) << std::endl;
-    geometry_msgs::Pose pose_in_lidar_tf;
-    
-    pose_in_lidar_tf.position.x = point.position(0);
-    pose_in_lidar_tf.position.y = point.position(1);
-    pose_in_lidar_tf.position.z = start_point_in_lidar_tf.z;
-    pose_in_lidar_tf.orientation.w = 1.0;
-    geometry_msgs::Pose pose_in_map_tf;
-    tf2::doTransform(pose_in_lidar_tf, pose_in_map_tf, lidar2map_tf);
-    autoware_msgs::Waypoint waypoint;
-    waypoint.pose.pose = pose_in_map_tf;
-    waypoint.cost = point.curvature;
-    debug_modified_smoothed_reference_path.push_back(waypoint);   
+    refined_points_in_lidar_tf.col(i) = refined_path[i].position;
+  }
+  const size_t debug_smoothed_path_offset = debug_modified_smoothed_reference_path.size();
+  appendWaypointsInMapFrame(refined_points_in_lidar_tf,
+                            start_point_in_lidar_tf.z,
+                            lidar2map_transform,
+                            debug_modified_smoothed_reference_path);
+  for(size_t i = 0; i < refined_path.size(); i++)
+  {
+    debug_modified_smoothed_reference_path[debug_smoothed_path_offset + i].cost = refined_path[i].curvature;
   }
   
   // for(const auto& point: refined_path)
@@ -786,41 +904,74 @@ bool ModifiedReferencePathGenerator::generateModifiedReferencePath(
   
   //bspline https://tajimarobotics.com/basis-spline-interpolation-program-2/
   int number_of_control_points = refined_path.size();
-  int degree_of_b_spline = 3;
+  int degree_of_b_spline = std::min(MAX_DEGREE_OF_B_SPLINE, number_of_control_points - 1);
   int number_of_knot = number_of_control_points + degree_of_b_spline + 1;
   std::vector<double> knot_vector =  
      generateOpenUniformKnotVector(number_of_knot, degree_of_b_spline);
-  int number_of_sampling_points = 60;
-  double delta_function_value = 1/static_cast<double>(number_of_sampling_points);
-  for(double i = 0; i < 1; i += delta_function_value)
-  {
-    double sum_x = 0;
-    double sum_y = 0;
-    for (size_t conrtol_point_index = 0; 
-         conrtol_point_index < refined_path.size();
-         conrtol_point_index++)
-    {
-      double calculated_value = calaculateBasisFunction(knot_vector,
-                                                  conrtol_point_index,
-                                                  degree_of_b_spline,
-                                                  i);
-      sum_x += refined_path[conrtol_point_index].position(0)*calculated_value;
-      sum_y += refined_path[conrtol_point_index].position(1)*calculated_value;
+  // sampling interval per knot span from the length and curvature of its control polygon,
+  // so that the chord error stays below B_SPLINE_MAX_CHORD_ERROR
+  std::vector<double> sampling_function_values;
+  for(int span = degree_of_b_spline; span < number_of_control_points; span++)
+  {
+    const double span_begin = knot_vector[span];
+    const double span_end = knot_vector[span + 1];
+    if(span_end <= span_begin)
+    {
+      continue;
+    }
+    double polygon_length = 0;
+    double max_abs_curvature = 0;
+    for(int j = span - degree_of_b_spline; j < span; j++)
+    {
+      polygon_length += calculate2DDistace(refined_path[j].position, refined_path[j+1].position);
+      if(j > span - degree_of_b_spline)
+      {
+        const double curvature = calculateCurvatureFromThreePoints(refined_path[j-1].position,
+                                                                   refined_path[j].position,
+                                                                   refined_path[j+1].position);
+        if(std::isfinite(curvature))
+        {
+          max_abs_curvature = std::max(max_abs_curvature, std::abs(curvature));
+        }
+      }
+    }
+    // each polygon segment is shared by degree spans
+    const double span_length = polygon_length/std::max(degree_of_b_spline, 1);
+    double sampling_interval = B_SPLINE_MAX_SAMPLING_INTERVAL;
+    if(max_abs_curvature > 0)
+    {
+      sampling_interval = std::min(sampling_interval, std::sqrt(8*B_SPLINE_MAX_CHORD_ERROR/max_abs_curvature));
+    }
+    const int number_of_span_samples = std::max(1, static_cast<int>(std::ceil(span_length/sampling_interval)));
+    for(int j = 0; j < number_of_span_samples; j++)
+    {
+      sampling_function_values.push_back(span_begin + (span_end - span_begin)*j/number_of_span_samples);
     }
-    
-    // std::cerr << "sumx " << sum_x << std::endl;
-    // std::cerr << "sumy " << sum_y << std::endl;
-    geometry_msgs::Pose pose_in_lidar_tf;
-    pose_in_lidar_tf.position.x = sum_x;
-    pose_in_lidar_tf.position.y = sum_y;
-    pose_in_lidar_tf.position.z = start_point_in_lidar_tf.z;
-    pose_in_lidar_tf.orientation.w = 1.0;
-    geometry_msgs::Pose pose_in_map_tf;
-    tf2::doTransform(pose_in_lidar_tf, pose_in_map_tf, lidar2map_tf);
-    autoware_msgs::Waypoint waypoint;
-    waypoint.pose.pose = pose_in_map_tf;
-    debug_bspline_path.push_back(waypoint);
-    modified_reference_path.push_back(waypoint); 
   }
+  sampling_function_values.push_back(knot_vector.back());
+  
+  Eigen::Matrix2Xd b_spline_points_in_lidar_tf(2, sampling_function_values.size());
+  for(size_t i = 0; i < sampling_function_values.size(); i++)
+  {
+    const double function_value = sampling_function_values[i];
+    const size_t knot_span = findKnotSpan(knot_vector,
+                                          degree_of_b_spline,
+                                          number_of_control_points,
+                                          function_value);
+    const Eigen::Vector2d b_spline_point = evaluateBSpline(refined_path,
+                                                          knot_vector,
+                                                          degree_of_b_spline,
+                                                          knot_span,
+                                                          function_value);
+    b_spline_points_in_lidar_tf.col(i) = b_spline_point;
+  }
+  const size_t bspline_path_offset = debug_bspline_path.size();
+  appendWaypointsInMapFrame(b_spline_points_in_lidar_tf,
+                            start_point_in_lidar_tf.z,
+                            lidar2map_transform,
+                            debug_bspline_path);
+  modified_reference_path.insert(modified_reference_path.end(),
+                                 debug_bspline_path.begin() + bspline_path_offset,
+                                 debug_bspline_path.end());
   return true;
 }
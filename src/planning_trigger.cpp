@@ -0,0 +1,71 @@
+#include "planning_trigger.h"
+
+namespace
+{
+std::chrono::steady_clock::duration toDuration(const double second)
+{
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(second));
+}
+}
+
+PlanningTrigger::PlanningTrigger(const double min_delta_second, const double max_delta_second):
+min_period_(toDuration(min_delta_second)),
+max_period_(toDuration(max_delta_second)),
+number_of_pending_events_(0),
+number_of_coalesced_events_(0),
+is_shutdown_(false),
+last_start_time_(std::chrono::steady_clock::now())
+{
+}
+
+PlanningTrigger::~PlanningTrigger()
+{
+}
+
+void PlanningTrigger::notify()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    number_of_pending_events_++;
+  }
+  condition_.notify_one();
+}
+
+bool PlanningTrigger::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait_until(lock, last_start_time_ + max_period_, [this]()
+  {
+    return number_of_pending_events_ > 0 || is_shutdown_;
+  });
+  // events during the rest of the minimum period join this start
+  if(number_of_pending_events_ > 0)
+  {
+    condition_.wait_until(lock, last_start_time_ + min_period_, [this]()
+    {
+      return is_shutdown_;
+    });
+  }
+  if(is_shutdown_)
+  {
+    return false;
+  }
+  number_of_coalesced_events_ = number_of_pending_events_;
+  number_of_pending_events_ = 0;
+  last_start_time_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+void PlanningTrigger::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_shutdown_ = true;
+  }
+  condition_.notify_all();
+}
+
+size_t PlanningTrigger::getNumberOfCoalescedEvents() const
+{
+  return number_of_coalesced_events_;
+}
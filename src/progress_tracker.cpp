@@ -0,0 +1,77 @@
+#include <limits>
+#include <algorithm>
+
+#include "progress_tracker.h"
+
+ProgressTracker::ProgressTracker(const size_t backward_window, const size_t forward_window):
+backward_window_(backward_window),
+forward_window_(forward_window),
+path_size_(0),
+nearest_index_(0),
+number_of_visited_points_(0)
+{
+}
+
+ProgressTracker::~ProgressTracker()
+{
+}
+
+size_t ProgressTracker::findNearestIndex(const std::shared_ptr<const void>& path_owner,
+                                         const size_t path_size,
+                                         const std::function<double(const size_t)>& squared_distance)
+{
+  number_of_visited_points_ = 0;
+  if(path_size == 0)
+  {
+    path_owner_.reset();
+    path_size_ = 0;
+    return path_size;
+  }
+  
+  size_t begin_index = 0;
+  size_t end_index = path_size;
+  const bool is_same_path = path_owner == path_owner_ && path_size == path_size_;
+  if(is_same_path)
+  {
+    begin_index = nearest_index_ > backward_window_ ? nearest_index_ - backward_window_ : 0;
+    end_index = std::min(nearest_index_ + forward_window_ + 1, path_size);
+  }
+  
+  double min_squared_distance = std::numeric_limits<double>::max();
+  size_t nearest_index = begin_index;
+  for(size_t i = begin_index; i < end_index; i++)
+  {
+    const double distance = squared_distance(i);
+    if(distance < min_squared_distance)
+    {
+      min_squared_distance = distance;
+      nearest_index = i;
+    }
+  }
+  number_of_visited_points_ = end_index - begin_index;
+  
+  // the ego moved further than the window; follow the path while it keeps getting closer
+  if(is_same_path)
+  {
+    for(size_t i = end_index; nearest_index + 1 == i && i < path_size; i++)
+    {
+      const double distance = squared_distance(i);
+      number_of_visited_points_++;
+      if(distance < min_squared_distance)
+      {
+        min_squared_distance = distance;
+        nearest_index = i;
+      }
+    }
+  }
+  
+  path_owner_ = path_owner;
+  path_size_ = path_size;
+  nearest_index_ = nearest_index;
+  return nearest_index;
+}
+
+size_t ProgressTracker::getNumberOfVisitedPoints() const
+{
+  return number_of_visited_points_;
+}
@@ -0,0 +1,70 @@
+#include "rigid_transform.h"
+
+RigidTransform::RigidTransform(const geometry_msgs::TransformStamped& transform):
+rotation_(transform.transform.rotation.w,
+          transform.transform.rotation.x,
+          transform.transform.rotation.y,
+          transform.transform.rotation.z),
+translation_(transform.transform.translation.x,
+             transform.transform.translation.y,
+             transform.transform.translation.z)
+{
+  rotation_.normalize();
+  rotation_matrix_ = rotation_.toRotationMatrix();
+}
+
+RigidTransform::~RigidTransform()
+{
+}
+
+void RigidTransform::transformPoints(const Eigen::Matrix3Xd& points,
+                                     Eigen::Matrix3Xd& transformed_points) const
+{
+  transformed_points.noalias() = rotation_matrix_*points;
+  transformed_points.colwise() += translation_;
+}
+
+void RigidTransform::transformPoints(const Eigen::Matrix2Xd& points,
+                                     const double z,
+                                     Eigen::Matrix3Xd& transformed_points) const
+{
+  // the constant height folds into the translation
+  const Eigen::Vector3d translation = rotation_matrix_.col(2)*z + translation_;
+  transformed_points.noalias() = rotation_matrix_.leftCols<2>()*points;
+  transformed_points.colwise() += translation;
+}
+
+Eigen::Vector3d RigidTransform::transformPoint(const Eigen::Vector3d& point) const
+{
+  return rotation_matrix_*point + translation_;
+}
+
+geometry_msgs::Point RigidTransform::transformPoint(const geometry_msgs::Point& point) const
+{
+  const Eigen::Vector3d transformed_point = transformPoint(Eigen::Vector3d(point.x, point.y, point.z));
+  geometry_msgs::Point transformed_point_msg;
+  transformed_point_msg.x = transformed_point(0);
+  transformed_point_msg.y = transformed_point(1);
+  transformed_point_msg.z = transformed_point(2);
+  return transformed_point_msg;
+}
+
+geometry_msgs::Quaternion RigidTransform::transformOrientation(const geometry_msgs::Quaternion& orientation) const
+{
+  const Eigen::Quaterniond transformed_orientation =
+    rotation_*Eigen::Quaterniond(orientation.w, orientation.x, orientation.y, orientation.z);
+  geometry_msgs::Quaternion transformed_orientation_msg;
+  transformed_orientation_msg.x = transformed_orientation.x();
+  transformed_orientation_msg.y = transformed_orientation.y();
+  transformed_orientation_msg.z = transformed_orientation.z();
+  transformed_orientation_msg.w = transformed_orientation.w();
+  return transformed_orientation_msg;
+}
+
+geometry_msgs::Pose RigidTransform::transformPose(const geometry_msgs::Pose& pose) const
+{
+  geometry_msgs::Pose transformed_pose;
+  transformed_pose.position = transformPoint(pose.position);
+  transformed_pose.orientation = transformOrientation(pose.orientation);
+  return transformed_pose;
+}
@@ -0,0 +1,70 @@
+#include <cmath>
+#include <algorithm>
+
+#include "tiled_clearance_grid.h"
+
+constexpr int TiledClearanceGrid::TILE_ROWS;
+constexpr int TiledClearanceGrid::TILE_COLS;
+constexpr int TiledClearanceGrid::TILE_SIZE;
+constexpr int TiledClearanceGrid::CACHE_LINE_BYTES;
+
+TiledClearanceGrid::TiledClearanceGrid():
+rows_(0),
+cols_(0),
+number_of_tile_rows_(0),
+top_left_corner_(Eigen::Vector2d::Zero()),
+inverse_resolution_(0),
+aligned_offset_(0)
+{
+}
+
+TiledClearanceGrid::~TiledClearanceGrid()
+{
+}
+
+void TiledClearanceGrid::build(const grid_map::Matrix& data,
+                               const grid_map::Position& map_position,
+                               const double resolution,
+                               const double meters_per_unit)
+{
+  rows_ = data.rows();
+  cols_ = data.cols();
+  number_of_tile_rows_ = (rows_ + TILE_ROWS - 1)/TILE_ROWS;
+  const int number_of_tile_cols = (cols_ + TILE_COLS - 1)/TILE_COLS;
+  top_left_corner_ = map_position + 0.5*resolution*Eigen::Vector2d(rows_, cols_);
+  inverse_resolution_ = 1.0/resolution;
+  // padding cells of partial tiles are never read
+  centimeters_.assign(number_of_tile_rows_*number_of_tile_cols*TILE_SIZE + TILE_SIZE, 0);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(centimeters_.data());
+  aligned_offset_ = ((CACHE_LINE_BYTES - address%CACHE_LINE_BYTES)%CACHE_LINE_BYTES)/sizeof(uint16_t);
+  const float units_to_centimeters = meters_per_unit*100.0;
+  for(int col = 0; col < cols_; col++)
+  {
+    for(int row = 0; row < rows_; row++)
+    {
+      const float centimeters = std::round(data(row, col)*units_to_centimeters);
+      centimeters_[calculateOffset(row, col)] =
+        static_cast<uint16_t>(std::min(std::max(centimeters, 0.0f), 65535.0f));
+    }
+  }
+}
+
+size_t TiledClearanceGrid::sample(const Eigen::Matrix2Xd& positions,
+                                  Eigen::VectorXd& clearances,
+                                  const double invalid_clearance) const
+{
+  clearances.resize(positions.cols());
+  size_t number_of_valid_positions = 0;
+  for(int i = 0; i < positions.cols(); i++)
+  {
+    double clearance = invalid_clearance;
+    number_of_valid_positions += sample(positions.col(i), clearance);
+    clearances(i) = clearance;
+  }
+  return number_of_valid_positions;
+}
+
+size_t TiledClearanceGrid::getMemoryBytes() const
+{
+  return centimeters_.size()*sizeof(uint16_t);
+}
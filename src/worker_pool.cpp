@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(const size_t num_threads):
+is_stopped_(false)
+{
+  size_t num_workers = num_threads;
+  if(num_workers == 0)
+  {
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for(size_t i = 0; i < num_workers; i++)
+  {
+    workers_.emplace_back(&WorkerPool::work, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopped_ = true;
+  }
+  condition_.notify_all();
+  for(auto& worker: workers_)
+  {
+    worker.join();
+  }
+}
+
+size_t WorkerPool::size() const
+{
+  return workers_.size();
+}
+
+void WorkerPool::work()
+{
+  while(true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this](){ return is_stopped_ || !tasks_.empty(); });
+      if(is_stopped_ && tasks_.empty())
+      {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+  }
+}
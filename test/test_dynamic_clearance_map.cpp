@@ -0,0 +1,120 @@
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <grid_map_core/TypeDefs.hpp>
+
+#include "clearance_map_generator.h"
+
+namespace
+{
+const int ROWS = 60;
+const int COLS = 50;
+const double RESOLUTION = 0.1;
+const int NUM_INITIAL_OBSTACLES = 40;
+const int MAX_EDITS_PER_FRAME = 20;
+const int NUM_FRAMES = 200;
+// every few frames the map also moves by a few cells as when the ego drives
+const int SHIFT_INTERVAL = 4;
+const int MAX_SHIFT_CELLS = 3;
+// cells; incremental propagation along 8 neighbours against the exact transform
+const float MAX_CLEARANCE_ERROR = 1e-3f;
+
+// cell (r, c) becomes (r + shift_rows, c + shift_cols); entering cells are free
+grid_map::Matrix shiftCostmap(const grid_map::Matrix& costmap, const int shift_rows, const int shift_cols)
+{
+  grid_map::Matrix shifted = grid_map::Matrix::Zero(costmap.rows(), costmap.cols());
+  for(int col = 0; col < costmap.cols(); col++)
+  {
+    for(int row = 0; row < costmap.rows(); row++)
+    {
+      const int old_row = row - shift_rows;
+      const int old_col = col - shift_cols;
+      if(old_row >= 0 && old_row < costmap.rows() && old_col >= 0 && old_col < costmap.cols())
+      {
+        shifted(row, col) = costmap(old_row, old_col);
+      }
+    }
+  }
+  return shifted;
+}
+
+float calculateMaxError(const grid_map::Matrix& costmap,
+                        const grid_map::Position& map_position,
+                        ClearanceMapGenerator& incremental_generator,
+                        const ClearanceMapGenerator& full_generator)
+{
+  grid_map::Matrix incremental_clearance = costmap;
+  const bool incremental_has_obstacle =
+    incremental_generator.updateClearanceMap(incremental_clearance, map_position, RESOLUTION);
+  grid_map::Matrix full_clearance = costmap;
+  const bool full_has_obstacle = full_generator.generateClearanceMap(full_clearance);
+  EXPECT_EQ(full_has_obstacle, incremental_has_obstacle);
+  return (incremental_clearance - full_clearance).cwiseAbs().maxCoeff();
+}
+}
+
+TEST(DynamicClearanceMap, MatchesFullRecomputationOnRandomEdits)
+{
+  std::mt19937 random_engine(3);
+  std::uniform_int_distribution<int> random_row(0, ROWS - 1);
+  std::uniform_int_distribution<int> random_col(0, COLS - 1);
+  std::uniform_int_distribution<int> random_edits(0, MAX_EDITS_PER_FRAME);
+  std::uniform_int_distribution<int> random_shift(-MAX_SHIFT_CELLS, MAX_SHIFT_CELLS);
+
+  grid_map::Matrix costmap = grid_map::Matrix::Zero(ROWS, COLS);
+  for(int i = 0; i < NUM_INITIAL_OBSTACLES; i++)
+  {
+    costmap(random_row(random_engine), random_col(random_engine)) = 1;
+  }
+  grid_map::Position map_position = grid_map::Position::Zero();
+  ClearanceMapGenerator incremental_generator(1);
+  ClearanceMapGenerator full_generator(1);
+  EXPECT_LT(calculateMaxError(costmap, map_position, incremental_generator, full_generator), MAX_CLEARANCE_ERROR);
+
+  for(int frame = 1; frame <= NUM_FRAMES; frame++)
+  {
+    if(frame % SHIFT_INTERVAL == 0)
+    {
+      const int shift_rows = random_shift(random_engine);
+      const int shift_cols = random_shift(random_engine);
+      costmap = shiftCostmap(costmap, shift_rows, shift_cols);
+      map_position += grid_map::Position(shift_rows, shift_cols)*RESOLUTION;
+    }
+    const int number_of_edits = random_edits(random_engine);
+    for(int i = 0; i < number_of_edits; i++)
+    {
+      float& cost = costmap(random_row(random_engine), random_col(random_engine));
+      cost = cost > 0 ? 0 : 1;
+    }
+    EXPECT_LT(calculateMaxError(costmap, map_position, incremental_generator, full_generator), MAX_CLEARANCE_ERROR)
+      << "frame " << frame;
+  }
+  // only the first frame is computed from scratch
+  EXPECT_LT(incremental_generator.getNumberOfChangedCells(), static_cast<size_t>(ROWS*COLS));
+}
+
+TEST(DynamicClearanceMap, RemovingEveryObstacleGivesConstantClearance)
+{
+  grid_map::Matrix costmap = grid_map::Matrix::Zero(ROWS, COLS);
+  costmap(ROWS/2, COLS/2) = 1;
+  costmap(1, 2) = 1;
+  const grid_map::Position map_position = grid_map::Position::Zero();
+  ClearanceMapGenerator incremental_generator(1);
+  ClearanceMapGenerator full_generator(1);
+  EXPECT_LT(calculateMaxError(costmap, map_position, incremental_generator, full_generator), MAX_CLEARANCE_ERROR);
+
+  costmap.setZero();
+  EXPECT_LT(calculateMaxError(costmap, map_position, incremental_generator, full_generator), MAX_CLEARANCE_ERROR);
+  grid_map::Matrix clearance = costmap;
+  EXPECT_FALSE(incremental_generator.updateClearanceMap(clearance, map_position, RESOLUTION));
+  EXPECT_EQ(1.0f, clearance.minCoeff());
+  EXPECT_EQ(1.0f, clearance.maxCoeff());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
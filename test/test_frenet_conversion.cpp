@@ -0,0 +1,114 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include <autoware_msgs/Waypoint.h>
+
+#include "frenet_geometry.h"
+#include "calculate_center_line.h"
+
+namespace
+{
+// counterclockwise circular lane
+const double LANE_RADIUS = 20.0;
+const double LANE_LENGTH = 60.0;
+// to the right of the lane, i.e. outside of the circle
+const double FRENET_D = 1.0;
+const double QUERY_INTERVAL = 0.05;
+
+// metres; worst case between center line points on the arc up to 8 m spacing
+const double MAX_ARC_ERROR = 0.01;
+
+struct ConversionError
+{
+  double straight;
+  double arc;
+};
+
+std::vector<autoware_msgs::Waypoint> generateCircularLane(const double spacing)
+{
+  std::vector<autoware_msgs::Waypoint> waypoints;
+  for(double s = 0; s <= LANE_LENGTH; s += spacing)
+  {
+    autoware_msgs::Waypoint waypoint;
+    waypoint.pose.pose.position.x = LANE_RADIUS*std::sin(s/LANE_RADIUS);
+    waypoint.pose.pose.position.y = LANE_RADIUS - LANE_RADIUS*std::cos(s/LANE_RADIUS);
+    waypoints.push_back(waypoint);
+  }
+  return waypoints;
+}
+
+// worst error of the frenet to cartesian conversion from the nearest center line point,
+// straight along its yaw and along the arc of its curvature
+ConversionError measureConversionError(const double spacing)
+{
+  CalculateCenterLine calculate_center_line;
+  const std::vector<Point> center_line_points =
+    calculate_center_line.calculateCenterLineFromGlobalWaypoints(generateCircularLane(spacing));
+  ConversionError error;
+  error.straight = 0;
+  error.arc = 0;
+  // CalculateCenterLine estimates no curvature for the first two and the last point
+  for(size_t i = 2; i + 1 < center_line_points.size(); i++)
+  {
+    const Point& lane_point = center_line_points[i];
+    for(double delta_s = -spacing/2; delta_s <= spacing/2; delta_s += QUERY_INTERVAL)
+    {
+      // cumulated_s sums chords, so the arc length of the point is taken from the lane instead
+      const double s = i*spacing + delta_s;
+      const double expected_x = (LANE_RADIUS + FRENET_D)*std::sin(s/LANE_RADIUS);
+      const double expected_y = LANE_RADIUS - (LANE_RADIUS + FRENET_D)*std::cos(s/LANE_RADIUS);
+      double offset_x, offset_y, arc_yaw;
+      calculateFrenetOffset<double>(lane_point.rz, delta_s, FRENET_D, offset_x, offset_y);
+      error.straight = std::max(error.straight,
+                                std::hypot(lane_point.tx + offset_x - expected_x, lane_point.ty + offset_y - expected_y));
+      calculateFrenetOffsetOnArc<double>(lane_point.rz, lane_point.curvature, delta_s, FRENET_D,
+                                         offset_x, offset_y, arc_yaw);
+      error.arc = std::max(error.arc,
+                           std::hypot(lane_point.tx + offset_x - expected_x, lane_point.ty + offset_y - expected_y));
+    }
+  }
+  return error;
+}
+}
+
+TEST(FrenetConversion, AccuracyAgainstCenterLineDensity)
+{
+  const double spacings[] = {0.5, 1.0, 2.0, 4.0, 8.0};
+  double densest_straight_error = 0;
+  for(const double spacing: spacings)
+  {
+    const ConversionError error = measureConversionError(spacing);
+    std::cout << "spacing " << spacing << " m straight " << error.straight << " m arc " << error.arc << " m" << std::endl;
+    if(spacing == spacings[0])
+    {
+      densest_straight_error = error.straight;
+    }
+    EXPECT_LT(error.arc, MAX_ARC_ERROR) << "spacing " << spacing;
+    EXPECT_LT(error.arc, error.straight) << "spacing " << spacing;
+  }
+  // the sparsest center line on the arc is still more accurate than the densest one extrapolated straight
+  EXPECT_LT(measureConversionError(spacings[4]).arc, densest_straight_error);
+}
+
+TEST(FrenetConversion, ArcMatchesStraightWithoutCurvature)
+{
+  for(double delta_s = -4; delta_s <= 4; delta_s += 0.5)
+  {
+    double straight_x, straight_y;
+    calculateFrenetOffset<double>(0.3, delta_s, FRENET_D, straight_x, straight_y);
+    double arc_x, arc_y, arc_yaw;
+    calculateFrenetOffsetOnArc<double>(0.3, 0.0, delta_s, FRENET_D, arc_x, arc_y, arc_yaw);
+    EXPECT_NEAR(straight_x, arc_x, 1e-12);
+    EXPECT_NEAR(straight_y, arc_y, 1e-12);
+    EXPECT_NEAR(0.3, arc_yaw, 1e-12);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "frenet_geometry.h"
+#include "lateral_polynomial.h"
+
+namespace
+{
+// the single precision build has to stay within these of the double build
+// metres
+const double MAX_OFFSET_DEVIATION = 1e-4;
+const double MAX_LATERAL_DEVIATION = 1e-3;
+// radian
+const double MAX_YAW_DEVIATION = 1e-5;
+
+const double LANE_YAWS[] = {-3.1, -1.2, 0.0, 0.7, 2.5};
+const double LANE_CURVATURES[] = {-0.2, -0.01, 0.0, 0.0005, 0.05, 0.2};
+const double DELTA_SS[] = {0.1, 1.0, 5.0, 20.0, 40.0};
+const double FRENET_DS[] = {-4.0, -0.25, 0.0, 1.5, 4.0};
+}
+
+TEST(PlannerKernels, FrenetOffsetFloatMatchesDouble)
+{
+  for(const double lane_yaw: LANE_YAWS)
+  {
+    for(const double delta_s: DELTA_SS)
+    {
+      for(const double frenet_d: FRENET_DS)
+      {
+        double offset_x, offset_y;
+        calculateFrenetOffset<double>(lane_yaw, delta_s, frenet_d, offset_x, offset_y);
+        float offset_x_float, offset_y_float;
+        calculateFrenetOffset<float>(lane_yaw, delta_s, frenet_d, offset_x_float, offset_y_float);
+        EXPECT_NEAR(offset_x, offset_x_float, MAX_OFFSET_DEVIATION);
+        EXPECT_NEAR(offset_y, offset_y_float, MAX_OFFSET_DEVIATION);
+      }
+    }
+  }
+}
+
+TEST(PlannerKernels, FrenetOffsetOnArcFloatMatchesDouble)
+{
+  for(const double lane_yaw: LANE_YAWS)
+  {
+    for(const double lane_curvature: LANE_CURVATURES)
+    {
+      for(const double delta_s: DELTA_SS)
+      {
+        for(const double frenet_d: FRENET_DS)
+        {
+          double offset_x, offset_y, arc_yaw;
+          calculateFrenetOffsetOnArc<double>(lane_yaw, lane_curvature, delta_s, frenet_d,
+                                             offset_x, offset_y, arc_yaw);
+          float offset_x_float, offset_y_float, arc_yaw_float;
+          calculateFrenetOffsetOnArc<float>(lane_yaw, lane_curvature, delta_s, frenet_d,
+                                            offset_x_float, offset_y_float, arc_yaw_float);
+          EXPECT_NEAR(offset_x, offset_x_float, MAX_OFFSET_DEVIATION);
+          EXPECT_NEAR(offset_y, offset_y_float, MAX_OFFSET_DEVIATION);
+          EXPECT_NEAR(arc_yaw, arc_yaw_float, MAX_YAW_DEVIATION);
+        }
+      }
+    }
+  }
+}
+
+TEST(PlannerKernels, DistanceAndRadiusFloatMatchesDouble)
+{
+  for(const double dx: FRENET_DS)
+  {
+    for(const double dy: DELTA_SS)
+    {
+      EXPECT_NEAR(calculate2DDistance<double>(dx, dy), calculate2DDistance<float>(dx, dy), MAX_OFFSET_DEVIATION);
+      // away from the boundary both precisions agree
+      const double radius = calculate2DDistance<double>(dx, dy);
+      EXPECT_TRUE(isWithin2DRadius<float>(dx, dy, radius + MAX_OFFSET_DEVIATION));
+      EXPECT_FALSE(isWithin2DRadius<float>(dx, dy, radius - MAX_OFFSET_DEVIATION));
+    }
+  }
+}
+
+template <int Degree>
+void expectLateralPolynomialFloatMatchesDouble()
+{
+  const int NUM_SAMPLE = 20;
+  for(const double delta_s: DELTA_SS)
+  {
+    for(const double origin_d: FRENET_DS)
+    {
+      for(const double target_d: FRENET_DS)
+      {
+        const double start_slope = std::tan(0.1);
+        const LateralPolynomial<Degree, double> polynomial(origin_d, start_slope, target_d, delta_s);
+        const LateralPolynomial<Degree, float> polynomial_float(origin_d, start_slope, target_d, delta_s);
+        Eigen::Matrix<double, NUM_SAMPLE, 1> sampled_delta_s, sampled_d;
+        polynomial.template sample<NUM_SAMPLE>(delta_s, sampled_delta_s, sampled_d);
+        Eigen::Matrix<float, NUM_SAMPLE, 1> sampled_delta_s_float, sampled_d_float;
+        polynomial_float.template sample<NUM_SAMPLE>(delta_s, sampled_delta_s_float, sampled_d_float);
+        for(int i = 0; i < NUM_SAMPLE; i++)
+        {
+          EXPECT_NEAR(sampled_delta_s(i), sampled_delta_s_float(i), MAX_OFFSET_DEVIATION);
+          EXPECT_NEAR(sampled_d(i), sampled_d_float(i), MAX_LATERAL_DEVIATION)
+            << "degree " << Degree << " delta_s " << delta_s << " sample " << i;
+        }
+        EXPECT_NEAR(polynomial.evaluate(delta_s), target_d, MAX_LATERAL_DEVIATION);
+        EXPECT_NEAR(polynomial_float.evaluate(delta_s), target_d, MAX_LATERAL_DEVIATION);
+      }
+    }
+  }
+}
+
+TEST(PlannerKernels, CubicLateralPolynomialFloatMatchesDouble)
+{
+  expectLateralPolynomialFloatMatchesDouble<3>();
+}
+
+TEST(PlannerKernels, QuinticLateralPolynomialFloatMatchesDouble)
+{
+  expectLateralPolynomialFloatMatchesDouble<5>();
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}